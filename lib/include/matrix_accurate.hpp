@@ -0,0 +1,208 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include "matrix_arithmetic.hpp"
+#include "matrix_parallel.hpp"
+#include "matrix_storage.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Accurate summation for floating point product() and reductions:              |
+ * pairwise    - sums of blocks are added by binary tree, error grows as log(n), |
+ * compensated - Dot2/Sum2 (Ogita, Rump, Oishi): error terms of every product   |
+ *               and addition are kept exactly (fma or Dekker split) and added  |
+ *               at the end, result is as if computed in doubled precision.     |
+ * Both accumulate into lanes independent accumulators, so inner loops have no  |
+ * dependency between iterations and are vectorized by compiler.                |
+ * Do not compile with -ffast-math: it removes compensation terms.              |
+ * Reductions with summation mode are reduce() of matrix_reduce.hpp.            |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+
+enum class Summation
+{
+    naive,
+    pairwise,
+    compensated,
+};
+
+namespace detail
+{
+
+constexpr std::size_t summation_lanes = 8;
+constexpr std::size_t pairwise_block  = 128;
+
+// a + b = sum + err exactly
+template<std::floating_point T>
+void two_sum(T a, T b, T& sum, T& err)
+{
+    sum = a + b;
+    T z = sum - a;
+    err = (a - (sum - z)) + (b - z);
+}
+
+// a * b = prod + err exactly
+template<std::floating_point T>
+void two_prod(T a, T b, T& prod, T& err)
+{
+    prod = a * b;
+#if defined(FP_FAST_FMA) && defined(FP_FAST_FMAF)
+    err = std::fma(a, b, -prod);
+#else
+    // Dekker: without hardware fma std::fma is software emulation, split is much faster
+    constexpr T factor = static_cast<T>((1ull << ((std::numeric_limits<T>::digits + 1) / 2)) + 1);
+    T a_big = factor * a, b_big = factor * b;
+    T a_hi = a_big - (a_big - a), b_hi = b_big - (b_big - b);
+    T a_lo = a - a_hi, b_lo = b - b_hi;
+    err = ((a_hi * b_hi - prod) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+#endif
+}
+
+// sum of x[i * x_step] * y[i * y_step] (y == nullptr means y[i] = 1) for i in [0, len)
+template<std::floating_point T>
+T naive_dot(const T* x, std::size_t x_step, const T* y, std::size_t y_step, std::size_t len)
+{
+    T lanes[summation_lanes] {};
+    std::size_t i = 0;
+    for (; i + summation_lanes <= len; i += summation_lanes)
+        for (std::size_t l = 0; l < summation_lanes; l++)
+            lanes[l] += x[(i + l) * x_step] * (y ? y[(i + l) * y_step] : T{1});
+    for (; i < len; i++)
+        lanes[0] += x[i * x_step] * (y ? y[i * y_step] : T{1});
+
+    T res {};
+    for (auto lane: lanes)
+        res += lane;
+    return res;
+}
+
+template<std::floating_point T>
+T pairwise_dot(const T* x, std::size_t x_step, const T* y, std::size_t y_step, std::size_t len)
+{
+    if (len <= pairwise_block)
+        return naive_dot(x, x_step, y, y_step, len);
+    std::size_t half = len / 2 / pairwise_block * pairwise_block;
+    if (half == 0)
+        half = len / 2;
+    return pairwise_dot(x, x_step, y, y_step, half) +
+           pairwise_dot(x + half * x_step, x_step, y ? y + half * y_step : y, y_step, len - half);
+}
+
+// result is res + err, err is kept apart so that sums of parts can be compensated further
+template<std::floating_point T>
+void compensated_dot(const T* x, std::size_t x_step, const T* y, std::size_t y_step, std::size_t len, T& res, T& err)
+{
+    T sums[summation_lanes] {}, errs[summation_lanes] {};
+    auto step = [&](std::size_t l, std::size_t i)
+    {
+        T prod, prod_err, sum_err;
+        if (y)
+            two_prod(x[i * x_step], y[i * y_step], prod, prod_err);
+        else
+        {
+            prod = x[i * x_step];
+            prod_err = T{};
+        }
+        two_sum(sums[l], prod, sums[l], sum_err);
+        errs[l] += prod_err + sum_err;
+    };
+
+    std::size_t i = 0;
+    for (; i + summation_lanes <= len; i += summation_lanes)
+        for (std::size_t l = 0; l < summation_lanes; l++)
+            step(l, i + l);
+    for (; i < len; i++)
+        step(0, i);
+
+    res = err = T{};
+    for (std::size_t l = 0; l < summation_lanes; l++)
+    {
+        T sum_err;
+        two_sum(res, sums[l], res, sum_err);
+        err += errs[l] + sum_err;
+    }
+}
+
+template<std::floating_point T>
+T compensated_dot(const T* x, std::size_t x_step, const T* y, std::size_t y_step, std::size_t len)
+{
+    T res, err;
+    compensated_dot(x, x_step, y, y_step, len, res, err);
+    return res + err;
+}
+
+template<std::floating_point T>
+T dot(const T* x, std::size_t x_step, const T* y, std::size_t y_step, std::size_t len, Summation mode)
+{
+    switch (mode)
+    {
+        case Summation::pairwise:
+            return pairwise_dot(x, x_step, y, y_step, len);
+        case Summation::compensated:
+            return compensated_dot(x, x_step, y, y_step, len);
+        default:
+            return naive_dot(x, x_step, y, y_step, len);
+    }
+}
+
+// dot() as res + err, err is not zero only for compensated summation
+template<std::floating_point T>
+void dot(const T* x, std::size_t x_step, const T* y, std::size_t y_step, std::size_t len, Summation mode, T& res, T& err)
+{
+    if (mode == Summation::compensated)
+        compensated_dot(x, x_step, y, y_step, len, res, err);
+    else
+    {
+        res = dot(x, x_step, y, y_step, len, mode);
+        err = T{};
+    }
+}
+
+// rows of matrix in one contiguous buffer
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+aligned_vector<T> row_major_copy(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    aligned_vector<T> res (mat.height() * mat.width());
+    for (std::size_t i = 0; i < mat.height(); i++)
+        std::copy(mat[i].begin(), mat[i].end(), res.begin() + i * mat.width());
+    return res;
+}
+
+} // namespace detail
+
+// dot product of rows of lhs and columns of rhs with given summation, rows are computed in parallel
+template<std::floating_point T, bool IsDivArithm, class Cmp, class Abs>
+MatrixArithmetic<T, IsDivArithm, Cmp, Abs> product(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs,
+                                                   const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs,
+                                                   Summation mode)
+{
+    if (mode == Summation::naive || lhs.is_scalar() || rhs.is_scalar())
+        return product(lhs, rhs);
+    if (lhs.width() != rhs.height())
+        throw std::invalid_argument{"in product: lhs.width() != rhs.height()"};
+
+    MATRIX_PROFILE_SCOPE("product_accurate");
+    std::size_t m = lhs.height(), k = lhs.width(), n = rhs.width();
+    MATRIX_PROFILE_TEMPORARY((m + n) * k * sizeof(T));
+    MATRIX_PROFILE_FLOPS(((mode == Summation::compensated) ? 10 : 2) * m * n * k);
+
+    auto a = detail::row_major_copy(lhs);
+    auto bt = detail::row_major_copy(rhs.transpos()); // columns of rhs are contiguous
+
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> res (m, n);
+    detail::parallel_for(0, m, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; i++)
+            for (std::size_t j = 0; j < n; j++)
+                res.to(i, j) = detail::dot(a.data() + i * k, 1, bt.data() + j * k, 1, k, mode);
+    }, std::max<std::size_t>(1, (1 << 16) / std::max<std::size_t>(1, n * k)));
+
+    return res;
+}
+
+} // namespace Matrix
@@ -1,5 +1,16 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <latch>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "matrix_container.hpp"
+#include "matrix_parallel.hpp"
 
 namespace Matrix
 {
@@ -16,8 +27,91 @@ struct DefaultAbs
     int  operator()(const T& arg) const {return 0;}
 };
 
+// type of absolute values of elements, norms have it
+template<typename T, class Abs>
+using abs_type = std::decay_t<decltype(std::declval<const Abs&>()(std::declval<const T&>()))>;
+
+// x -= a * b, type can do it without temporaries by member fused_mul_sub(a, b) (see matrix_exact.hpp)
+template<typename T>
+void fused_mul_sub(T& x, const T& a, const T& b)
+{
+    if constexpr (requires {x.fused_mul_sub(a, b);})
+        x.fused_mul_sub(a, b);
+    else
+        x -= a * b;
 }
 
+// sum of row[k] * x[k] for k in [0, len), floating point sum goes by independent lanes to be vectorized
+template<typename RowIt, typename T>
+T dot_kernel(RowIt row, const T* x, std::size_t len)
+{
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        constexpr std::size_t lanes_num = 8;
+        T lanes[lanes_num] {};
+        std::size_t k = 0;
+        for (; k + lanes_num <= len; k += lanes_num)
+            for (std::size_t l = 0; l < lanes_num; l++)
+                lanes[l] += row[k + l] * x[k + l];
+        for (; k < len; k++)
+            lanes[0] += row[k] * x[k];
+        T res {};
+        for (auto lane: lanes)
+            res += lane;
+        return res;
+    }
+    else
+    {
+        T res {};
+        for (std::size_t k = 0; k < len; k++)
+            res += row[k] * x[k];
+        return res;
+    }
+}
+
+// y = mat * x, rows go in parallel
+template<typename Mat, typename T>
+void gemv_kernel(const Mat& mat, const T* x, T* y)
+{
+    parallel_for(0, mat.height(), [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; i++)
+            y[i] = dot_kernel(mat[i].begin(), x, mat.width());
+    }, rows_per_chunk(mat.width()));
+}
+
+// y = mat^T * x as sum of rows scaled by x, columns are split between threads
+template<typename Mat, typename T>
+void gemv_transposed_kernel(const Mat& mat, const T* x, T* y)
+{
+    parallel_for(0, mat.width(), [&](std::size_t first, std::size_t last)
+    {
+        std::fill(y + first, y + last, T{});
+        for (std::size_t k = 0; k < mat.height(); k++)
+        {
+            auto row = mat[k].begin();
+            const T x_k = x[k];
+            for (std::size_t j = first; j < last; j++)
+                y[j] += x_k * row[j];
+        }
+    }, rows_per_chunk(mat.height()));
+}
+
+// x = (x * d - b * c) / div, step of Bareiss algorithm, type can do it by member mul_sub_div(d, b, c, div)
+template<typename T>
+void mul_sub_div(T& x, const T& d, const T& b, const T& c, const T& div)
+{
+    if constexpr (requires {x.mul_sub_div(d, b, c, div);})
+        x.mul_sub_div(d, b, c, div);
+    else
+        x = (x * d - b * c) / div;
+}
+
+}
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+class LUDecomposition;
+
 template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
 /*
  *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -47,8 +141,14 @@ public:
     using typename base::reverse_iterator;
     using typename base::const_reverse_iterator;
 
+    using permutation_type = std::vector<size_type>;
+
 protected:    
+    friend class LUDecomposition<T, IsDivArithm, Cmp, Abs>;
+
     static constexpr bool is_div_arithmetical = IsDivArithm;
+    // determinant() switches to parallel elimination from this side of matrix
+    static constexpr size_type parallel_elimination_threshold = 256;
     Cmp cmp {};
     Abs abs {};
 
@@ -56,10 +156,10 @@ public:
 //--------------------------------=| Ctors start |=-----------------------------------------------------
     MatrixArithmetic(): base() {}
 
-    MatrixArithmetic(size_type h, size_type w): base(h, w) {}
+    MatrixArithmetic(size_type h, size_type w, const AllocationPolicy& policy = {}): base(h, w, policy) {}
 
-    MatrixArithmetic(size_type h, size_type w, const_reference val)
-    :base(h, w, val)
+    MatrixArithmetic(size_type h, size_type w, const_reference val, const AllocationPolicy& policy = {})
+    :base(h, w, val, policy)
     {}
 
     template<std::input_iterator InpIt>
@@ -81,19 +181,41 @@ public:
 //--------------------------------=| Ctors end |=-------------------------------------------------------
 
 //--------------------------------=| Algorithm fucntions start |=---------------------------------------
+/*
+ * Elimination engine does not move rows: logical row i is physical row perm[i],
+ * row swap is swap of two indexes in perm. Methods below take perm that was built by
+ * identity_permutation() and continue to use it, so result is upper triangular
+ * in logical order of rows.
+ */
 protected:
-    size_type row_with_max_fst(size_type iteration)
+    static permutation_type identity_permutation(size_type sz)
+    {
+        permutation_type perm (sz);
+        std::iota(perm.begin(), perm.end(), size_type{0});
+        return perm;
+    }
+
+    size_type row_with_max_fst(size_type iteration, const permutation_type& perm) const
     {
+        MATRIX_PROFILE_SCOPE("row_with_max_fst");
         size_type res = iteration;
-        for (size_type i = iteration; i < this->height(); i++)
-            if (abs(this->to(i, iteration)) > abs(this->to(res, iteration)))
+        auto max_abs = abs(this->to(perm[iteration], iteration));
+        for (size_type i = iteration + 1; i < this->height(); i++)
+        {
+            auto cur_abs = abs(this->to(perm[i], iteration));
+            if (cur_abs > max_abs)
+            {
                 res = i;
+                max_abs = cur_abs;
+            }
+        }
         return res;
     }
 
     // method for types with non aritmetic division by Bareiss algorithm Bareiss 
-    value_type make_upper_triangular_square(size_type side_of_square) 
+    value_type make_upper_triangular_square(size_type side_of_square, permutation_type& perm) 
     {
+        MATRIX_PROFILE_SCOPE("make_upper_triangular_square");
         if (side_of_square > std::min(this->height(), this->width()))
             throw std::invalid_argument{"try to make upper triangular square that no inside matrix"};
 
@@ -102,28 +224,35 @@ protected:
         value_type null_obj {};
         for (size_type i = 0; i < side_of_square - 1; i++)
         {
-            auto row_to_swap = row_with_max_fst(i);
+            auto row_to_swap = row_with_max_fst(i, perm);
             if (row_to_swap != i)
             {
-                this->swap_row(i, row_to_swap);
+                std::swap(perm[i], perm[row_to_swap]);
                 sign *= value_type{-1};
             }
-            if (!cmp(this->to(i, i), null_obj))
+            const auto& row_i = (*this)[perm[i]];
+            if (!cmp(row_i[i], null_obj))
             {
                 for (size_type j = i + 1; j < side_of_square; j++)
+                {
+                    auto& row_j = (*this)[perm[j]];
                     for (size_type k = i + 1; k < side_of_square; k++)
-                        this->to(j, k) = (this->to(j, k) * this->to(i, i) - this->to(j, i) * this->to(i, k)) / div_coef;
-                div_coef = this->to(i, i);
+                        detail::mul_sub_div(row_j[k], row_i[i], row_j[i], row_i[k], div_coef);
+                }
+                div_coef = row_i[i];
+                MATRIX_PROFILE_FLOPS(4 * (side_of_square - i - 1) * (side_of_square - i - 1));
             }
             else
                 sign = null_obj;
         }
-        return this->to(side_of_square - 1, side_of_square - 1) * sign;
+        return this->to(perm[side_of_square - 1], side_of_square - 1) * sign;
     }
     
-    // method for types with arithmetic division by Gauss algorithm
-    value_type make_upper_triangular_square(size_type side_of_square) requires is_div_arithmetical
+    // method for types with arithmetic division by Gauss algorithm,
+    // multipliers of L are saved under diagonal, so square becomes packed LU of permuted rows
+    value_type make_upper_triangular_square(size_type side_of_square, permutation_type& perm) requires is_div_arithmetical
     {
+        MATRIX_PROFILE_SCOPE("make_upper_triangular_square");
         if (side_of_square > std::min(this->height(), this->width()))
             throw std::invalid_argument{"try to make upper triangular square that no inside matrix"};
     
@@ -131,46 +260,217 @@ protected:
         value_type null_obj {};
         for (size_type i = 0; i < side_of_square - 1; i++)
         {
-            auto row_to_swap = row_with_max_fst(i);
+            auto row_to_swap = row_with_max_fst(i, perm);
             if (row_to_swap != i)
             {
-                this->swap_row(i, row_with_max_fst(i));
+                std::swap(perm[i], perm[row_to_swap]);
                 sign *= value_type{-1};
             }
-            if (!cmp(this->to(i, i), null_obj))
+            const auto& row_i = (*this)[perm[i]];
+            if (!cmp(row_i[i], null_obj))
                 for (size_type j = i + 1; j < side_of_square; j++)
                 {
-                    value_type coef = this->to(j, i) / this->to(i, i);
-                    for (size_type k = i; k < this->width(); k++)
-                        this->to(j, k) -= coef * this->to(i, k);
+                    auto& row_j = (*this)[perm[j]];
+                    value_type coef = row_j[i] / row_i[i];
+                    for (size_type k = i + 1; k < this->width(); k++)
+                        detail::fused_mul_sub(row_j[k], coef, row_i[k]);
+                    row_j[i] = coef;
+                    MATRIX_PROFILE_FLOPS(1 + 2 * (this->width() - i - 1));
+                }
+        }
+        return sign;
+    }
+
+    /*
+     * Gauss elimination split across threads reserved from budget of detail::parallel_for (at most
+     * n_threads with calling one): row perm[j] belongs to thread j % n_workers for whole elimination.
+     * On step i every thread updates column i + 1 of its rows and looks for max of it, finishes whole
+     * row of its candidate and arrives at barrier. Completion function reduces candidates (ties go to
+     * lower position as in serial elimination) and swaps pivot into perm, while workers update rest of
+     * their rows: lookahead, pivot is always finished candidate, so next step doesn't wait for them.
+     */
+    value_type make_upper_triangular_square_parallel(size_type side_of_square, permutation_type& perm,
+                                                     size_type n_threads) requires is_div_arithmetical
+    {
+        if (side_of_square > std::min(this->height(), this->width()))
+            throw std::invalid_argument{"try to make upper triangular square that no inside matrix"};
+
+        n_threads = std::min(n_threads, side_of_square);
+        size_type n_extra = (n_threads > 1) ? detail::acquire_threads(n_threads - 1) : 0;
+        detail::ThreadRegion region {n_extra};
+        if (n_extra == 0)
+            return make_upper_triangular_square(side_of_square, perm);
+
+        MATRIX_PROFILE_SCOPE("make_upper_triangular_square_parallel");
+        struct Candidate
+        {
+            size_type row; // index of row in data, not in perm
+            bool is_valid;
+        };
+
+        value_type sign {1};
+        value_type null_obj {};
+        size_type step = 0, n_workers = 1;
+        bool is_pivot_null = false;
+        std::vector<Candidate> candidates;
+        std::vector<size_type> position (this->height());
+        for (size_type j = 0; j < side_of_square; j++)
+            position[perm[j]] = j;
+
+        auto is_better = [&](size_type row, size_type other, size_type col)
+        {
+            return abs(this->to(row, col)) > abs(this->to(other, col)) ||
+                   (!(abs(this->to(row, col)) < abs(this->to(other, col))) && position[row] < position[other]);
+        };
+
+        auto choose_pivot = [&]() noexcept
+        {
+            if (step < side_of_square)
+            {
+                size_type pivot = perm[step];
+                for (const auto& cand: candidates)
+                    if (cand.is_valid && is_better(cand.row, pivot, step))
+                        pivot = cand.row;
+                size_type pivot_pos = position[pivot];
+                if (pivot_pos != step)
+                {
+                    std::swap(perm[step], perm[pivot_pos]);
+                    position[perm[pivot_pos]] = pivot_pos;
+                    position[pivot] = step;
+                    sign *= value_type{-1};
                 }
+                is_pivot_null = cmp(this->to(pivot, step), null_obj);
+            }
+            step++;
+        };
+        std::optional<std::barrier<decltype(choose_pivot)>> sync_point;
+
+        // workers wait until number of started threads is known, gate is opened on unwind too
+        std::latch start {1};
+        bool is_cancelled = false;
+        struct Gate
+        {
+            std::latch& start;
+            bool& is_cancelled;
+            bool is_open = false;
+
+            void open() {is_open = true; start.count_down();}
+            ~Gate() {if (!is_open) {is_cancelled = true; start.count_down();}}
+        } gate {start, is_cancelled};
+
+        auto worker = [&](size_type thread_id)
+        {
+            start.wait();
+            if (is_cancelled)
+                return;
+
+            std::vector<size_type> rows;
+            for (size_type j = thread_id; j < side_of_square; j += n_workers)
+                rows.push_back(perm[j]);
+
+            Candidate best {0, false};
+            for (auto row: rows)
+                if (!best.is_valid || is_better(row, best.row, 0))
+                    best = {row, true};
+            candidates[thread_id] = best;
+            sync_point->arrive_and_wait();
+
+            // rows updated after arrival with their coefficients
+            std::vector<std::pair<value_type*, value_type>> rest;
+            for (size_type i = 0; i < side_of_square - 1; i++)
+            {
+                const bool is_null = is_pivot_null;
+                const value_type* row_i = (*this)[perm[i]].data();
+                best = {0, false};
+                size_type best_rest = 0;
+                rest.clear();
+                for (auto row: rows)
+                {
+                    if (position[row] <= i)
+                        continue;
+                    value_type* row_j = (*this)[row].data();
+                    if (!is_null)
+                    {
+                        value_type coef = row_j[i] / row_i[i];
+                        detail::fused_mul_sub(row_j[i + 1], coef, row_i[i + 1]);
+                        row_j[i] = coef;
+                        rest.emplace_back(row_j, coef);
+                    }
+                    if (!best.is_valid || is_better(row, best.row, i + 1))
+                    {
+                        best = {row, true};
+                        best_rest = rest.size() - 1;
+                    }
+                }
+
+                auto finish = [&](value_type* row_j, const value_type& coef)
+                {
+                    for (size_type k = i + 2; k < this->width(); k++)
+                        detail::fused_mul_sub(row_j[k], coef, row_i[k]);
+                };
+                if (!is_null && best.is_valid)
+                {
+                    finish(rest[best_rest].first, rest[best_rest].second);
+                    rest[best_rest].first = nullptr;
+                }
+                candidates[thread_id] = best;
+                auto token = sync_point->arrive();
+                for (const auto& [row_j, coef]: rest)
+                    if (row_j)
+                        finish(row_j, coef);
+                sync_point->wait(std::move(token));
+            }
+        };
+
+        size_type n_started = 0;
+        try
+        {
+            region.threads.reserve(n_extra);
+            for (; n_started < n_extra; n_started++)
+                region.threads.emplace_back(worker, n_started + 1);
         }
+        catch (...) {}
+
+        n_workers = n_started + 1;
+        candidates.assign(n_workers, Candidate{0, false});
+        sync_point.emplace(static_cast<std::ptrdiff_t>(n_workers), choose_pivot);
+        gate.open();
+        worker(0);
+        region.join();
+
+        MATRIX_PROFILE_FLOPS(2 * side_of_square * side_of_square * side_of_square / 3);
         return sign;
     }
 
-    void make_eye_square_from_upper_triangular_square(size_type side_of_square) requires is_div_arithmetical
+    void make_eye_square_from_upper_triangular_square(size_type side_of_square, const permutation_type& perm) requires is_div_arithmetical
     {
+        MATRIX_PROFILE_SCOPE("make_eye_square_from_upper_triangular_square");
         for (size_type i = side_of_square - 1; static_cast<long long>(i) >= 0; i--)
         {
-            auto coef = this->to(i, i);
+            auto& row_i = (*this)[perm[i]];
+            auto coef = row_i[i];
             for (size_type j = i; j < this->width(); j++)
-                this->to(i, j) /= coef;
+                row_i[j] /= coef;
         }
         
         for (size_type i = side_of_square - 1; static_cast<long long>(i) >= 0; i--)
+        {
+            const auto& row_i = (*this)[perm[i]];
             for (size_type j = 0; j < i; j++)
             {
-                auto coef = this->to(j, i);
+                auto& row_j = (*this)[perm[j]];
+                auto coef = row_j[i];
                 for(size_type k = i; k < this->width(); k++)
-                    this->to(j, k) -= this->to(i, k) * coef;
+                    detail::fused_mul_sub(row_j[k], row_i[k], coef);
             }
+        }
     }
 
-    value_type determinant_for_upper_triangular(size_type side_of_square) const requires is_div_arithmetical
+    value_type determinant_for_upper_triangular(size_type side_of_square, const permutation_type& perm) const requires is_div_arithmetical
     {
         value_type res {1};
         for (size_type i = 0; i < side_of_square; i++)
-            res *= this->to(i, i);
+            res *= this->to(perm[i], i);
         return res;
     }
 //--------------------------------=| Algorithm fucntions end |=-----------------------------------------
@@ -182,9 +482,33 @@ public:
         if (!this->is_square())
             throw std::invalid_argument{"try to get determinant() of no square matrix"};
 
+        // exact fractions (see matrix_exact.hpp) can go by fraction free elimination found by ADL
+        if constexpr (requires {fraction_free_determinant(*this);})
+            if (auto res = fraction_free_determinant(*this))
+                return *res;
+
+        if (this->height() >= parallel_elimination_threshold)
+            return determinant_parallel();
+
+        MATRIX_PROFILE_SCOPE("determinant");
         MatrixArithmetic cpy (*this);
-        value_type sign = cpy.make_upper_triangular_square(this->height());
-        return sign * cpy.determinant_for_upper_triangular(this->height());
+        MATRIX_PROFILE_TEMPORARY(this->height() * this->width() * sizeof(value_type));
+        auto perm = identity_permutation(this->height());
+        value_type sign = cpy.make_upper_triangular_square(this->height(), perm);
+        return sign * cpy.determinant_for_upper_triangular(this->height(), perm);
+    }
+
+    value_type determinant_parallel(size_type n_threads = detail::hardware_threads()) const requires is_div_arithmetical
+    {
+        if (!this->is_square())
+            throw std::invalid_argument{"try to get determinant() of no square matrix"};
+
+        MATRIX_PROFILE_SCOPE("determinant");
+        MatrixArithmetic cpy (*this);
+        MATRIX_PROFILE_TEMPORARY(this->height() * this->width() * sizeof(value_type));
+        auto perm = identity_permutation(this->height());
+        value_type sign = cpy.make_upper_triangular_square_parallel(this->height(), perm, n_threads);
+        return sign * cpy.determinant_for_upper_triangular(this->height(), perm);
     }
 
     value_type determinant() const
@@ -192,8 +516,11 @@ public:
         if (!this->is_square())
             throw std::invalid_argument{"try to get determinant() of no square matrix"};
 
+        MATRIX_PROFILE_SCOPE("determinant");
         MatrixArithmetic cpy (*this);
-        return cpy.make_upper_triangular_square(this->height());
+        MATRIX_PROFILE_TEMPORARY(this->height() * this->width() * sizeof(value_type));
+        auto perm = identity_permutation(this->height());
+        return cpy.make_upper_triangular_square(this->height(), perm);
     }
 
     std::pair<bool, MatrixArithmetic> inverse_pair() const requires is_div_arithmetical
@@ -201,6 +528,7 @@ public:
         if (!this->is_square())
             throw std::invalid_argument{"try to get inverse matrix of no square matrix"};
 
+        MATRIX_PROFILE_SCOPE("inverse");
         MatrixArithmetic extended_mat (this->height(), 2 * this->height());
         for (size_type i = 0; i < this->height(); i++)
             for (size_type j = 0; j < this->height(); j++)
@@ -209,17 +537,18 @@ public:
         for (size_type i = 0; i < this->height(); i++)
             extended_mat.to(i, i + this->height()) = value_type{1};
 
-        extended_mat.make_upper_triangular_square(extended_mat.height());
+        auto perm = identity_permutation(this->height());
+        extended_mat.make_upper_triangular_square(extended_mat.height(), perm);
 
-        if (extended_mat.determinant_for_upper_triangular(extended_mat.height()) == value_type{})
+        if (extended_mat.determinant_for_upper_triangular(extended_mat.height(), perm) == value_type{})
             return {false, MatrixArithmetic{value_type{0}}};
 
-        extended_mat.make_eye_square_from_upper_triangular_square(extended_mat.height());
+        extended_mat.make_eye_square_from_upper_triangular_square(extended_mat.height(), perm);
         
         MatrixArithmetic res (this->height(), this->height());
         for (size_type i = 0; i < this->height(); i++)
             for (size_type j = 0; j < this->height(); j++)
-                res.to(i, j) = extended_mat.to(i, j + this->height());
+                res.to(i, j) = extended_mat.to(perm[i], j + this->height());
         
         return {true, res};
     }
@@ -235,10 +564,15 @@ public:
 
     MatrixArithmetic transpos() const
     {
+        MATRIX_PROFILE_SCOPE("transpos");
         MatrixArithmetic res (this->width(), this->height());
-        for (size_type i = 0; i < this->height(); i++)
-            for (size_type j = 0; j < this->width(); j++)
-                res.to(j, i) = this->to(i, j);
+        // rows of res are written by the same placed parts which built them in ctor
+        detail::placed_parallel_for(0, res.height(), [&](size_type first, size_type last)
+        {
+            for (size_type i = first; i < last; i++)
+                for (size_type j = 0; j < res.width(); j++)
+                    res.to(i, j) = this->to(j, i);
+        }, detail::rows_per_chunk(res.width()));
         return res;
     }
 //--------------------------------=| Public methods end |=----------------------------------------------
@@ -249,23 +583,45 @@ public:
         if (this->height() != rhs.height() || this->width() != rhs.width())
             return false;
 
-        for (size_type i = 0; i < this->height(); i++)
-            for (size_type j = 0; j < this->width(); j++)
-                if (!cmp(this->to(i, j), rhs.to(i, j)))
-                    return false;                  
-        return true;
+        MATRIX_PROFILE_SCOPE("equal_to");
+        // chunks of rows are compared in parallel, first mismatch stops all of them
+        std::atomic<bool> is_equal {true};
+        detail::parallel_for(0, this->height(), [&](size_type first, size_type last)
+        {
+            for (size_type i = first; i < last && is_equal.load(std::memory_order_relaxed); i++)
+                if (!std::equal((*this)[i].begin(), (*this)[i].end(), rhs[i].begin(), cmp))
+                    is_equal.store(false, std::memory_order_relaxed);
+        }, detail::rows_per_chunk(this->width()));
+        return is_equal.load();
     }
 //--------------------------------=| Compare end |=-----------------------------------------------------
 
 //--------------------------------=| Basic arithmetic start |=------------------------------------------
+private:
+    // rows of big matrix go by the same placed parts as in ctor, see MatrixContainer::make_rows()
+    template<typename Func>
+    void for_each_row_chunk(Func func) const
+    {
+        detail::placed_parallel_for(0, this->height(), [&](size_type first, size_type last)
+        {
+            for (size_type i = first; i < last; i++)
+                func(i);
+        }, detail::rows_per_chunk(this->width()));
+    }
+
+public:
     MatrixArithmetic& operator+=(const MatrixArithmetic& rhs)
     {
         if (this->height() != rhs.height() || this->width() != rhs.width())
             throw std::invalid_argument{"Try to add matrixes with different height() * width()"};
 
-        for (size_type i = 0; i < this->height(); i++)
+        MATRIX_PROFILE_SCOPE("operator+=");
+        MATRIX_PROFILE_FLOPS(this->height() * this->width());
+        for_each_row_chunk([&](size_type i)
+        {
             for (size_type j = 0; j < this->width(); j++)
                 this->to(i, j) += rhs.to(i, j);
+        });
 
         return *this;
     }
@@ -275,37 +631,52 @@ public:
         if (this->height() != rhs.height() || this->width() != rhs.width())
             throw std::invalid_argument{"Try to sub matrixes with different height() * width()"};
 
-        for (size_type i = 0; i < this->height(); i++)
+        MATRIX_PROFILE_SCOPE("operator-=");
+        MATRIX_PROFILE_FLOPS(this->height() * this->width());
+        for_each_row_chunk([&](size_type i)
+        {
             for (size_type j = 0; j < this->width(); j++)
                 this->to(i, j) -= rhs.to(i, j);
+        });
 
         return *this;
     }
 
     MatrixArithmetic operator-() const
     {
+        MATRIX_PROFILE_SCOPE("operator-(unary)");
         MatrixArithmetic res (this->height(), this->width());
 
-        for (size_type i = 0; i < this->height(); i++)
+        for_each_row_chunk([&](size_type i)
+        {
             for (size_type j = 0; j < this->width(); j++)
                 res.to(i, j) = -this->to(i, j);
+        });
 
         return res;
     }
 
     MatrixArithmetic& operator*=(const_reference rhs)
     {
-        for (auto& row: *this)
-            for (auto& elem: row)
+        MATRIX_PROFILE_SCOPE("operator*=");
+        MATRIX_PROFILE_FLOPS(this->height() * this->width());
+        for_each_row_chunk([&](size_type i)
+        {
+            for (auto& elem: (*this)[i])
                 elem *= rhs;
+        });
         return *this;
     }
 
     MatrixArithmetic& operator/=(const_reference rhs)
     {
-        for (auto& row: *this)
-            for (auto& elem: row)
+        MATRIX_PROFILE_SCOPE("operator/=");
+        MATRIX_PROFILE_FLOPS(this->height() * this->width());
+        for_each_row_chunk([&](size_type i)
+        {
+            for (auto& elem: (*this)[i])
                 elem /= rhs;
+        });
         return *this;
     }
 //--------------------------------=| Basic arithmetic end |=--------------------------------------------
@@ -400,9 +771,11 @@ MatrixArithmetic<T, IsDivArithm, Cmp, Abs> transpos(const MatrixArithmetic<T, Is
 template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
 MatrixArithmetic<T, IsDivArithm, Cmp, Abs> product(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs, const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs)
 {
+    MATRIX_PROFILE_SCOPE("product");
     if (lhs.is_scalar())
     {
         MatrixArithmetic res (rhs);
+        MATRIX_PROFILE_TEMPORARY(rhs.height() * rhs.width() * sizeof(T));
         const auto& scalar = scalar_cast(lhs);
         for (auto& row: res)
             for (auto& elem: row)
@@ -412,6 +785,7 @@ MatrixArithmetic<T, IsDivArithm, Cmp, Abs> product(const MatrixArithmetic<T, IsD
     if (rhs.is_scalar())
     {
         MatrixArithmetic res (lhs);
+        MATRIX_PROFILE_TEMPORARY(lhs.height() * lhs.width() * sizeof(T));
         const auto& scalar = scalar_cast(rhs);
         for (auto& row: res)
             for (auto& elem: row)
@@ -421,9 +795,27 @@ MatrixArithmetic<T, IsDivArithm, Cmp, Abs> product(const MatrixArithmetic<T, IsD
     if (lhs.width() != rhs.height())
         throw std::invalid_argument{"in product: lhs.width() != rhs.height()"};
 
-    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> res (lhs.height(), rhs.width());
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> res (lhs.height(), rhs.width(), lhs.allocation());
 
     using size_type = typename MatrixArithmetic<T, IsDivArithm, Cmp, Abs>::size_type;
+    MATRIX_PROFILE_FLOPS(2 * lhs.height() * rhs.width() * lhs.width());
+
+    // matrix-vector products go by GEMV kernels on contiguous copy of vector
+    if (rhs.is_column() || lhs.is_row())
+    {
+        bool is_gemv = rhs.is_column();
+        std::vector<T> x (lhs.width()), y (is_gemv ? lhs.height() : rhs.width());
+        MATRIX_PROFILE_TEMPORARY((x.size() + y.size()) * sizeof(T));
+        for (size_type k = 0; k < x.size(); k++)
+            x[k] = is_gemv ? rhs.to(k, 0) : lhs.to(0, k);
+        if (is_gemv)
+            detail::gemv_kernel(lhs, x.data(), y.data());
+        else
+            detail::gemv_transposed_kernel(rhs, x.data(), y.data());
+        for (size_type i = 0; i < y.size(); i++)
+            (is_gemv ? res.to(i, 0) : res.to(0, i)) = std::move(y[i]);
+        return res;
+    }
 
     for (size_type i = 0; i < lhs.height(); i++)
         for (size_type j = 0; j < rhs.width(); j++)
@@ -439,6 +831,7 @@ MatrixArithmetic<T, IsDivArithm, Cmp, Abs> power(const MatrixArithmetic<T, IsDiv
         if (!mat.is_square())
             throw std::invalid_argument{"Try to make matrix in some power but this matrix is not square"};
 
+        MATRIX_PROFILE_SCOPE("power");
         if (pow == 0)
             return MatrixArithmetic<T, IsDivArithm, Cmp, Abs>::eye(mat.height());
 
@@ -471,6 +864,8 @@ bool operator!=(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs, const Mat
 template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
 MatrixArithmetic<T, IsDivArithm, Cmp, Abs> operator+(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs, const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs)
 {
+    MATRIX_PROFILE_SCOPE("operator+");
+    MATRIX_PROFILE_TEMPORARY(lhs.height() * lhs.width() * sizeof(T));
     MatrixArithmetic<T, IsDivArithm, Cmp, Abs> lhs_cpy (lhs);
     return (lhs_cpy += rhs);
 }
@@ -478,6 +873,8 @@ MatrixArithmetic<T, IsDivArithm, Cmp, Abs> operator+(const MatrixArithmetic<T, I
 template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
 MatrixArithmetic<T, IsDivArithm, Cmp, Abs> operator-(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs, const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs)
 {
+    MATRIX_PROFILE_SCOPE("operator-");
+    MATRIX_PROFILE_TEMPORARY(lhs.height() * lhs.width() * sizeof(T));
     MatrixArithmetic<T, IsDivArithm, Cmp, Abs> lhs_cpy (lhs);
     return (lhs_cpy -= rhs);
 }
@@ -485,6 +882,8 @@ MatrixArithmetic<T, IsDivArithm, Cmp, Abs> operator-(const MatrixArithmetic<T, I
 template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
 MatrixArithmetic<T, IsDivArithm, Cmp, Abs> operator*(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs, const T& rhs)
 {
+    MATRIX_PROFILE_SCOPE("operator*");
+    MATRIX_PROFILE_TEMPORARY(lhs.height() * lhs.width() * sizeof(T));
     MatrixArithmetic<T, IsDivArithm, Cmp, Abs> lhs_cpy (lhs);
     return (lhs_cpy *= rhs);
 }
@@ -498,6 +897,8 @@ MatrixArithmetic<T, IsDivArithm, Cmp, Abs> operator*(const T& lhs, const MatrixA
 template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
 MatrixArithmetic<T, IsDivArithm, Cmp, Abs> operator/(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs, const T& rhs)
 {
+    MATRIX_PROFILE_SCOPE("operator/");
+    MATRIX_PROFILE_TEMPORARY(lhs.height() * lhs.width() * sizeof(T));
     MatrixArithmetic<T, IsDivArithm, Cmp, Abs> lhs_cpy (lhs);
     return (lhs_cpy /= rhs);
 }
@@ -0,0 +1,245 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include "matrix_lu.hpp"
+#include "matrix_parallel.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Asynchronous operations. Every call returns Handle at once and operation is  |
+ * scheduled on shared ThreadPool. Handles passed as arguments are edges of     |
+ * dependency graph: operation starts only when all its arguments are ready,    |
+ * so independent operations run at the same time and no worker ever waits.     |
+ * Exception of operation is passed to all dependent ones and rethrown in get().|
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+namespace async
+{
+namespace detail
+{
+
+class NodeBase
+{
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<std::function<void()>> continuations_;
+    bool is_done_ = false;
+
+protected:
+    std::exception_ptr error_ {};
+
+public:
+    virtual ~NodeBase() = default;
+
+    // call func when node is done, at once if it is already done
+    void on_complete(std::function<void()> func)
+    {
+        {
+            std::lock_guard lock {mutex_};
+            if (!is_done_)
+            {
+                continuations_.push_back(std::move(func));
+                return;
+            }
+        }
+        func();
+    }
+
+    // only first completion counts, later ones are ignored;
+    // continuations must not throw, they run in completing task
+    void complete(std::exception_ptr error = nullptr)
+    {
+        std::vector<std::function<void()>> continuations;
+        {
+            std::lock_guard lock {mutex_};
+            if (is_done_)
+                return;
+            error_ = error;
+            is_done_ = true;
+            continuations.swap(continuations_);
+        }
+        cond_.notify_all();
+        for (auto& func: continuations)
+            func();
+    }
+
+    void wait()
+    {
+        std::unique_lock lock {mutex_};
+        cond_.wait(lock, [this]{return is_done_;});
+    }
+
+    bool is_done()
+    {
+        std::lock_guard lock {mutex_};
+        return is_done_;
+    }
+
+    std::exception_ptr error() const {return error_;}
+};
+
+template<typename R>
+class Node : public NodeBase
+{
+    std::optional<R> value_ {};
+
+public:
+    void set_value(R value)
+    {
+        if (is_done())
+            return;
+        value_.emplace(std::move(value));
+        complete();
+    }
+
+    // valid only after node is done without error
+    const R& value() const {return *value_;}
+};
+
+} // namespace detail
+
+template<typename R>
+class Handle
+{
+    std::shared_ptr<detail::Node<R>> node_;
+
+public:
+    using value_type = R;
+
+    explicit Handle(std::shared_ptr<detail::Node<R>> node): node_ {std::move(node)} {}
+
+    // blocks until result is ready, must not be called from tasks of pool
+    const R& get() const
+    {
+        node_->wait();
+        if (node_->error())
+            std::rethrow_exception(node_->error());
+        return node_->value();
+    }
+
+    void wait() const {node_->wait();}
+    bool is_ready() const {return node_->is_done();}
+
+    const std::shared_ptr<detail::Node<R>>& node() const {return node_;}
+};
+
+// ready handle to use value as argument of asynchronous operations
+template<typename R>
+Handle<std::decay_t<R>> value(R&& val)
+{
+    auto node = std::make_shared<detail::Node<std::decay_t<R>>>();
+    node->set_value(std::forward<R>(val));
+    return Handle<std::decay_t<R>>{node};
+}
+
+// run func(args.get()...) on pool when all args are ready
+template<typename Func, typename... Args>
+auto launch(ThreadPool& pool, Func func, Handle<Args>... args)
+{
+    using result_type = std::decay_t<std::invoke_result_t<Func, const Args&...>>;
+    auto node = std::make_shared<detail::Node<result_type>>();
+
+    // one extra count holds start until all continuations are registered
+    auto pending = std::make_shared<std::atomic<std::size_t>>(sizeof...(Args) + 1);
+    auto start = [&pool, node, func, args...]
+    {
+        std::exception_ptr error {};
+        ((error = error ? error : args.node()->error()), ...);
+        if (error)
+        {
+            node->complete(error);
+            return;
+        }
+        // continuations of node run outside of try, so their failure never completes node twice
+        try
+        {
+            pool.submit([node, func, args...]
+            {
+                std::optional<result_type> value {};
+                try {value.emplace(func(args.node()->value()...));}
+                catch (...)
+                {
+                    node->complete(std::current_exception());
+                    return;
+                }
+                node->set_value(std::move(*value));
+            });
+        }
+        catch (...) {node->complete(std::current_exception());}
+    };
+    auto release = [pending, start]
+    {
+        if (pending->fetch_sub(1) == 1)
+            start();
+    };
+
+    (args.node()->on_complete(release), ...);
+    release();
+    return Handle<result_type>{node};
+}
+
+template<typename Func, typename... Args>
+auto launch(Func func, Handle<Args>... args)
+{
+    return launch(ThreadPool::shared(), std::move(func), std::move(args)...);
+}
+
+//--------------------------------=| Operations start |=------------------------------------------------
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>> product(const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& lhs,
+                                                           const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& rhs)
+{
+    using matrix_type = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+    return launch([](const matrix_type& l, const matrix_type& r) {return Matrix::product(l, r);}, lhs, rhs);
+}
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+Handle<T> determinant(const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& mat)
+{
+    using matrix_type = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+    return launch([](const matrix_type& m) {return m.determinant();}, mat);
+}
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>> inverse(const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& mat)
+{
+    using matrix_type = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+    return launch([](const matrix_type& m) {return m.inverse();}, mat);
+}
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>> solve(const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& mat,
+                                                         const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& rhs)
+{
+    using matrix_type = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+    return launch([](const matrix_type& m, const matrix_type& r) {return Matrix::solve(m, r);}, mat, rhs);
+}
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>> operator+(const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& lhs,
+                                                             const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& rhs)
+{
+    using matrix_type = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+    return launch([](const matrix_type& l, const matrix_type& r) {return l + r;}, lhs, rhs);
+}
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>> operator-(const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& lhs,
+                                                             const Handle<MatrixArithmetic<T, IsDivArithm, Cmp, Abs>>& rhs)
+{
+    using matrix_type = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+    return launch([](const matrix_type& l, const matrix_type& r) {return l - r;}, lhs, rhs);
+}
+//--------------------------------=| Operations end |=--------------------------------------------------
+
+} // namespace async
+} // namespace Matrix
@@ -0,0 +1,231 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <variant>
+#include "matrix_lu.hpp"
+
+namespace Matrix
+{
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * MatrixArithmetic that remembers results of determinant(), inverse() and lu()  |
+ * until matrix is changed. Every non const access (to(), at(), operator[],     |
+ * swap_row(), iterators, compound operators, assignment) bumps version() and   |
+ * so drops cache. Changes done through reference to base class are not seen,  |
+ * call invalidate() after them. The same holds for Row&, reference or iterator |
+ * kept from before query: write through it after determinant(), inverse() or  |
+ * lu() is not seen, so take them again or call invalidate() after writing.     |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+class CachedMatrix : public MatrixArithmetic<T, IsDivArithm, Cmp, Abs>
+{
+public:
+    using base = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+
+    using typename base::size_type;
+    using typename base::value_type;
+    using typename base::reference;
+    using typename base::const_reference;
+    using typename base::Row;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using typename base::reverse_iterator;
+    using typename base::const_reverse_iterator;
+
+    using lu_type = LUDecomposition<T, IsDivArithm, Cmp, Abs>;
+
+private:
+    struct Cache
+    {
+        std::uint64_t version = 0;
+        std::optional<value_type> determinant {};
+        std::optional<base> inverse {};
+        std::conditional_t<IsDivArithm, std::optional<lu_type>, std::monostate> lu {};
+    };
+
+    std::atomic<std::uint64_t> version_ = 1;
+    mutable Cache cache_ {};
+    mutable std::mutex mutex_ {};
+
+    // drops cache computed for old version, must be called under lock
+    Cache& actual_cache() const
+    {
+        auto version = version_.load();
+        if (cache_.version != version)
+            cache_ = Cache{version};
+        return cache_;
+    }
+
+    const lu_type& lu_unlocked() const requires IsDivArithm
+    {
+        auto& cache = actual_cache();
+        if (!cache.lu)
+            cache.lu.emplace(static_cast<const base&>(*this));
+        return *cache.lu;
+    }
+
+public:
+//--------------------------------=| Ctors start |=-----------------------------------------------------
+    using base::base;
+
+    CachedMatrix(const base& mat): base(mat) {}
+    CachedMatrix(base&& mat): base(std::move(mat)) {}
+
+    CachedMatrix(const CachedMatrix& other): base(other) {}
+    CachedMatrix(CachedMatrix&& other): base(std::move(other)) {}
+
+    CachedMatrix& operator=(const CachedMatrix& other)
+    {
+        invalidate();
+        base::operator=(other);
+        return *this;
+    }
+
+    CachedMatrix& operator=(CachedMatrix&& other)
+    {
+        invalidate();
+        base::operator=(std::move(other));
+        return *this;
+    }
+//--------------------------------=| Ctors end |=-------------------------------------------------------
+
+//--------------------------------=| Version start |=---------------------------------------------------
+    std::uint64_t version() const {return version_.load();}
+    void invalidate() {version_.fetch_add(1);}
+//--------------------------------=| Version end |=-----------------------------------------------------
+
+//--------------------------------=| Acces operators start |=-------------------------------------------
+    using base::to;
+    using base::at;
+    using base::operator[];
+    using base::begin;
+    using base::end;
+    using base::rbegin;
+    using base::rend;
+
+    reference to(size_type i, size_type j) noexcept
+    {
+        invalidate();
+        return base::to(i, j);
+    }
+
+    Row& at(size_type ind)
+    {
+        invalidate();
+        return base::at(ind);
+    }
+
+    Row& operator[](size_type ind)
+    {
+        invalidate();
+        return base::operator[](ind);
+    }
+
+    iterator begin() {invalidate(); return base::begin();}
+    iterator end()   {invalidate(); return base::end();}
+
+    reverse_iterator rbegin() {invalidate(); return base::rbegin();}
+    reverse_iterator rend()   {invalidate(); return base::rend();}
+
+    void swap_row(size_type ind1, size_type ind2)
+    {
+        invalidate();
+        base::swap_row(ind1, ind2);
+    }
+
+    void swap_col(size_type ind1, size_type ind2)
+    {
+        invalidate();
+        base::swap_col(ind1, ind2);
+    }
+//--------------------------------=| Acces operators end |=---------------------------------------------
+
+//--------------------------------=| Compound operators start |=----------------------------------------
+    CachedMatrix& operator+=(const base& rhs)
+    {
+        invalidate();
+        base::operator+=(rhs);
+        return *this;
+    }
+
+    CachedMatrix& operator-=(const base& rhs)
+    {
+        invalidate();
+        base::operator-=(rhs);
+        return *this;
+    }
+
+    CachedMatrix& operator*=(const_reference rhs)
+    {
+        invalidate();
+        base::operator*=(rhs);
+        return *this;
+    }
+
+    CachedMatrix& operator/=(const_reference rhs)
+    {
+        invalidate();
+        base::operator/=(rhs);
+        return *this;
+    }
+//--------------------------------=| Compound operators end |=------------------------------------------
+
+//--------------------------------=| Memoized methods start |=------------------------------------------
+    // reference is valid until next change of matrix
+    const lu_type& lu() const requires IsDivArithm
+    {
+        std::lock_guard lock {mutex_};
+        return lu_unlocked();
+    }
+
+    value_type determinant() const
+    {
+        std::lock_guard lock {mutex_};
+        auto& cache = actual_cache();
+        if (!cache.determinant)
+        {
+            if constexpr (IsDivArithm)
+                cache.determinant = lu_unlocked().determinant();
+            else
+                cache.determinant = base::determinant();
+        }
+        return *cache.determinant;
+    }
+
+    base inverse() const requires IsDivArithm
+    {
+        std::lock_guard lock {mutex_};
+        auto& cache = actual_cache();
+        if (!cache.inverse)
+        {
+            const auto& mat_lu = lu_unlocked();
+            if (mat_lu.is_singular())
+                throw std::invalid_argument{"try to get inverse matrix for matrix with determinant equal to zero"};
+            cache.inverse = mat_lu.inverse();
+        }
+        return *cache.inverse;
+    }
+
+    std::pair<bool, base> inverse_pair() const requires IsDivArithm
+    {
+        {
+            std::lock_guard lock {mutex_};
+            if (lu_unlocked().is_singular())
+                return {false, base{value_type{0}}};
+        }
+        return {true, inverse()};
+    }
+
+    base solve(const base& rhs) const requires IsDivArithm
+    {
+        return lu().solve(rhs);
+    }
+//--------------------------------=| Memoized methods end |=--------------------------------------------
+};
+
+} // namespace Matrix
@@ -7,8 +7,13 @@
 #include <type_traits>
 #include <cstddef>
 #include <compare>
+#include <memory>
+#include <vector>
 
 #include "vector.hpp"
+#include "matrix_parallel.hpp"
+#include "matrix_profiler.hpp"
+#include "matrix_storage.hpp"
 
 namespace Matrix
 {
@@ -23,7 +28,8 @@ public:
     using pointer          = T*;
     using const_pointer    = const T*;
 
-    using Row = typename Container::Vector<value_type>;
+    // rows are allocated by AllocationPolicy of matrix (see matrix_storage.hpp)
+    using Row = std::vector<value_type, detail::RowAllocator<value_type>>;
 
     using row_iterator       = typename Row::iterator;
     using row_const_iterator = typename Row::const_iterator;
@@ -34,24 +40,50 @@ public:
 
 private:
     size_type height_ = 0, width_ = 0;
-    Container::Vector<Container::Vector<value_type>> data_ = {};
+    Container::Vector<Row> data_ = {};
+    AllocationPolicy policy_ {};
+
+    // row_maker(i, alloc) builds row i with allocator alloc, with block policy row i takes slot i of one block.
+    // Rows of big matrix are built by detail::placed_parallel_for, so with first touch placement pages of
+    // every part of rows are on node of cpu which will run the same part in elementwise operations
+    template<typename RowMaker>
+    void make_rows(RowMaker row_maker)
+    {
+        std::shared_ptr<detail::RowBlock> block {};
+        if (policy_.uses_block() && height_ != 0)
+            block = std::make_shared<detail::RowBlock>(height_, detail::padded_stride<value_type>(width_) * sizeof(value_type),
+                                                       policy_.huge_pages, policy_.numa == NumaPlacement::interleave);
+        detail::placed_parallel_for(0, height_, [&](size_type first, size_type last)
+        {
+            for (size_type i = first; i < last; i++)
+                data_[i] = row_maker(i, detail::RowAllocator<value_type>{block, i});
+        }, detail::rows_per_chunk(width_));
+    }
 
 public:
 //--------------------------------=| Classic ctors start |=---------------------------------------------
     MatrixContainer() = default;
     
-    MatrixContainer(size_type h, size_type w, const_reference val)
-    :height_ {h}, width_ {w}, data_ (height_, Row(width_, val))
-    {}
+    MatrixContainer(size_type h, size_type w, const_reference val, const AllocationPolicy& policy = {})
+    :height_ {h}, width_ {w}, data_ (height_), policy_ {policy}
+    {
+        MATRIX_PROFILE_ALLOC(height_ * width_ * sizeof(value_type));
+        make_rows([&](size_type, const auto& alloc) {return Row(width_, val, alloc);});
+    }
 
-    MatrixContainer(size_type h, size_type w)
-    :height_ {h}, width_ {w}, data_ (height_, Row(width_))
-    {}
+    MatrixContainer(size_type h, size_type w, const AllocationPolicy& policy = {})
+    :height_ {h}, width_ {w}, data_ (height_), policy_ {policy}
+    {
+        MATRIX_PROFILE_ALLOC(height_ * width_ * sizeof(value_type));
+        make_rows([&](size_type, const auto& alloc) {return Row(width_, alloc);});
+    }
 
     template<std::input_iterator InpIt>
     MatrixContainer(size_type h, size_type w, InpIt begin, InpIt end)
-    :height_ {h}, width_ {w}, data_ (height_, Row(width_))
+    :height_ {h}, width_ {w}, data_ (height_)
     {   
+        MATRIX_PROFILE_ALLOC(height_ * width_ * sizeof(value_type));
+        make_rows([&](size_type, const auto& alloc) {return Row(width_, alloc);});
         for (auto& row: data_)
             for (auto& elem: row)
                 if (begin != end)
@@ -86,18 +118,37 @@ private:
 public:
     MatrixContainer(std::initializer_list<std::initializer_list<value_type>> twodim_list)
     :height_ {twodim_list.size()}, width_ {calc_width(twodim_list)},
-     data_ (height_, Container::Vector<value_type>(width_))
+     data_ (height_, Row(width_))
     {
         size_type i = 0;
         for (auto& row: twodim_list)
             std::copy(row.begin(), row.end(), data_[i++].begin());
     }
+
+    MatrixContainer(const MatrixContainer& other)
+    :height_ {other.height_}, width_ {other.width_}, data_ (height_), policy_ {other.policy_}
+    {
+        make_rows([&](size_type i, const auto& alloc) {return Row(other.data_[i], alloc);});
+    }
+
+    MatrixContainer(MatrixContainer&& other) = default;
+
+    MatrixContainer& operator=(const MatrixContainer& other)
+    {
+        if (this != &other)
+            *this = MatrixContainer(other);
+        return *this;
+    }
+
+    MatrixContainer& operator=(MatrixContainer&& other) = default;
 //--------------------------------=| Classic ctors end |=-----------------------------------------------
 
 //--------------------------------=| Acces operators start |=-------------------------------------------
     size_type height() const {return height_;}
     size_type width()  const {return width_;}
 
+    const AllocationPolicy& allocation() const {return policy_;}
+
     reference to(size_type i, size_type j) noexcept
     {
         return data_[i][j];
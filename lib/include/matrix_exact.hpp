@@ -0,0 +1,832 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "matrix_arithmetic.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Exact element types for MatrixArithmetic:                                    |
+ * BigInt   - integer of any size, values that fit in int64 are kept inline     |
+ *            without allocation and go by fast path.                           |
+ *            Use MatrixArithmetic<BigInt> (Bareiss elimination).               |
+ * Rational - fraction of BigInt, gcd reduction is delayed until denominator    |
+ *            becomes long. Use MatrixArithmetic<Rational, true> (Gauss).       |
+ * Both have fused_mul_sub(a, b) (x -= a * b), BigInt has mul_sub_div() for     |
+ * Bareiss step (x = (x * d - b * c) / div), elimination engine calls them      |
+ * instead of operators to not create temporaries.                              |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+
+class BigInt
+{
+    using limb_type = std::uint32_t;
+    using wide_type = std::uint64_t;
+    using magnitude = std::vector<limb_type>;
+
+    static constexpr unsigned limb_bits = 32;
+
+    // value is small_ while mag_ is empty, otherwise it is (neg_ ? -mag_ : mag_) and does not fit in int64
+    std::int64_t small_ = 0;
+    bool neg_ = false;
+    magnitude mag_ {};
+
+//--------------------------------=| Magnitudes start |=------------------------------------------------
+    // limbs of any value, small value is spread in local buffer
+    struct Limbs
+    {
+        bool neg;
+        limb_type buf[2];
+        const limb_type* ptr;
+        std::size_t size;
+
+        explicit Limbs(const BigInt& x)
+        {
+            if (x.is_small())
+            {
+                neg = x.small_ < 0;
+                wide_type abs = neg ? wide_type{0} - static_cast<wide_type>(x.small_) : static_cast<wide_type>(x.small_);
+                buf[0] = static_cast<limb_type>(abs);
+                buf[1] = static_cast<limb_type>(abs >> limb_bits);
+                ptr = buf;
+                size = buf[1] ? 2 : (buf[0] ? 1 : 0);
+            }
+            else
+            {
+                neg = x.neg_;
+                ptr = x.mag_.data();
+                size = x.mag_.size();
+            }
+        }
+
+        Limbs(const Limbs&) = delete;
+        Limbs& operator=(const Limbs&) = delete;
+    };
+
+    // buffers for intermediate magnitudes, results are swapped with them to reuse capacity
+    static magnitude& scratch(std::size_t ind)
+    {
+        thread_local magnitude buffers[3];
+        return buffers[ind];
+    }
+
+    static int compare_mag(const limb_type* a, std::size_t an, const limb_type* b, std::size_t bn)
+    {
+        if (an != bn)
+            return (an < bn) ? -1 : 1;
+        for (std::size_t i = an; i-- > 0;)
+            if (a[i] != b[i])
+                return (a[i] < b[i]) ? -1 : 1;
+        return 0;
+    }
+
+    static void trim(magnitude& mag)
+    {
+        while (!mag.empty() && mag.back() == 0)
+            mag.pop_back();
+    }
+
+    // res = a + b, res must not alias a or b
+    static void add_mag(const limb_type* a, std::size_t an, const limb_type* b, std::size_t bn, magnitude& res)
+    {
+        if (an < bn)
+        {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+        res.resize(an + 1);
+        wide_type carry = 0;
+        for (std::size_t i = 0; i < an; i++)
+        {
+            carry += wide_type{a[i]} + ((i < bn) ? b[i] : 0);
+            res[i] = static_cast<limb_type>(carry);
+            carry >>= limb_bits;
+        }
+        res[an] = static_cast<limb_type>(carry);
+        trim(res);
+    }
+
+    // res = a - b for a >= b, res must not alias a or b
+    static void sub_mag(const limb_type* a, std::size_t an, const limb_type* b, std::size_t bn, magnitude& res)
+    {
+        res.resize(an);
+        wide_type borrow = 0;
+        for (std::size_t i = 0; i < an; i++)
+        {
+            wide_type sub = wide_type{(i < bn) ? b[i] : 0} + borrow;
+            res[i] = static_cast<limb_type>(wide_type{a[i]} - sub);
+            borrow = (a[i] < sub) ? 1 : 0;
+        }
+        trim(res);
+    }
+
+    // res = a * b, res must not alias a or b
+    static void mul_mag(const limb_type* a, std::size_t an, const limb_type* b, std::size_t bn, magnitude& res)
+    {
+        res.assign(an + bn, 0);
+        for (std::size_t i = 0; i < an; i++)
+        {
+            wide_type carry = 0;
+            for (std::size_t j = 0; j < bn; j++)
+            {
+                carry += wide_type{a[i]} * b[j] + res[i + j];
+                res[i + j] = static_cast<limb_type>(carry);
+                carry >>= limb_bits;
+            }
+            res[i + bn] = static_cast<limb_type>(carry);
+        }
+        trim(res);
+    }
+
+    // quot = u / v, rem = u % v for v != 0 (Knuth, algorithm D), quot and rem must not alias u or v
+    static void divmod_mag(const limb_type* u, std::size_t un, const limb_type* v, std::size_t vn,
+                           magnitude& quot, magnitude& rem)
+    {
+        if (compare_mag(u, un, v, vn) < 0)
+        {
+            quot.clear();
+            rem.assign(u, u + un);
+            return;
+        }
+        if (vn == 1)
+        {
+            quot.resize(un);
+            wide_type carry = 0;
+            for (std::size_t i = un; i-- > 0;)
+            {
+                wide_type cur = (carry << limb_bits) | u[i];
+                quot[i] = static_cast<limb_type>(cur / v[0]);
+                carry = cur % v[0];
+            }
+            trim(quot);
+            rem.assign(1, static_cast<limb_type>(carry));
+            trim(rem);
+            return;
+        }
+
+        // normalize so that highest bit of divisor is set
+        unsigned shift = std::countl_zero(v[vn - 1]);
+        thread_local magnitude vs, us;
+        vs.resize(vn);
+        us.resize(un + 1);
+        for (std::size_t i = vn; i-- > 0;)
+            vs[i] = (v[i] << shift) | ((shift && i) ? v[i - 1] >> (limb_bits - shift) : 0);
+        us[un] = shift ? u[un - 1] >> (limb_bits - shift) : 0;
+        for (std::size_t i = un; i-- > 0;)
+            us[i] = (u[i] << shift) | ((shift && i) ? u[i - 1] >> (limb_bits - shift) : 0);
+
+        constexpr wide_type base = wide_type{1} << limb_bits;
+        quot.assign(un - vn + 1, 0);
+        for (std::size_t j = un - vn + 1; j-- > 0;)
+        {
+            wide_type num = (wide_type{us[j + vn]} << limb_bits) | us[j + vn - 1];
+            wide_type qhat = num / vs[vn - 1];
+            wide_type rhat = num % vs[vn - 1];
+            while (qhat >= base || qhat * vs[vn - 2] > ((rhat << limb_bits) | us[j + vn - 2]))
+            {
+                qhat--;
+                rhat += vs[vn - 1];
+                if (rhat >= base)
+                    break;
+            }
+
+            std::int64_t borrow = 0;
+            for (std::size_t i = 0; i < vn; i++)
+            {
+                wide_type prod = qhat * vs[i];
+                std::int64_t t = static_cast<std::int64_t>(us[i + j]) - borrow - static_cast<std::int64_t>(prod & (base - 1));
+                us[i + j] = static_cast<limb_type>(t);
+                borrow = static_cast<std::int64_t>(prod >> limb_bits) - (t >> limb_bits);
+            }
+            std::int64_t t = static_cast<std::int64_t>(us[j + vn]) - borrow;
+            us[j + vn] = static_cast<limb_type>(t);
+
+            quot[j] = static_cast<limb_type>(qhat);
+            if (t < 0)
+            {
+                // qhat was one too big, add divisor back
+                quot[j]--;
+                wide_type carry = 0;
+                for (std::size_t i = 0; i < vn; i++)
+                {
+                    carry += wide_type{us[i + j]} + vs[i];
+                    us[i + j] = static_cast<limb_type>(carry);
+                    carry >>= limb_bits;
+                }
+                us[j + vn] += static_cast<limb_type>(carry);
+            }
+        }
+        trim(quot);
+
+        rem.resize(vn);
+        for (std::size_t i = 0; i < vn; i++)
+            rem[i] = (us[i] >> shift) | (shift ? us[i + 1] << (limb_bits - shift) : 0);
+        trim(rem);
+    }
+//--------------------------------=| Magnitudes end |=--------------------------------------------------
+
+    // takes value from mag (swaps buffers, so mag gets old capacity of this)
+    void assign_mag(bool neg, magnitude& mag)
+    {
+        if (mag.size() <= 2)
+        {
+            wide_type abs = mag.empty() ? 0 : mag[0];
+            if (mag.size() == 2)
+                abs |= wide_type{mag[1]} << limb_bits;
+            constexpr wide_type max_pos = static_cast<wide_type>(std::numeric_limits<std::int64_t>::max());
+            if (abs <= max_pos || (neg && abs == max_pos + 1))
+            {
+                small_ = neg ? static_cast<std::int64_t>(wide_type{0} - abs) : static_cast<std::int64_t>(abs);
+                neg_ = false;
+                mag_.clear();
+                return;
+            }
+        }
+        small_ = 0;
+        neg_ = neg;
+        mag_.swap(mag);
+    }
+
+    // this = a + (b_neg ? -|b| : |b|)
+    void assign_sum(const Limbs& a, const limb_type* b, std::size_t bn, bool b_neg)
+    {
+        auto& res = scratch(0);
+        if (a.neg == b_neg)
+        {
+            add_mag(a.ptr, a.size, b, bn, res);
+            assign_mag(a.neg, res);
+        }
+        else if (compare_mag(a.ptr, a.size, b, bn) >= 0)
+        {
+            sub_mag(a.ptr, a.size, b, bn, res);
+            assign_mag(a.neg, res);
+        }
+        else
+        {
+            sub_mag(b, bn, a.ptr, a.size, res);
+            assign_mag(b_neg, res);
+        }
+    }
+
+    static std::uint64_t gcd_small(std::uint64_t a, std::uint64_t b)
+    {
+        if (a == 0 || b == 0)
+            return a | b;
+        int shift = std::countr_zero(a | b);
+        a >>= std::countr_zero(a);
+        while (b != 0)
+        {
+            b >>= std::countr_zero(b);
+            if (a > b)
+                std::swap(a, b);
+            b -= a;
+        }
+        return a << shift;
+    }
+
+public:
+//--------------------------------=| Ctors start |=-----------------------------------------------------
+    BigInt() = default;
+
+    template<std::integral I>
+    BigInt(I value)
+    {
+        if constexpr (std::is_unsigned_v<I>)
+        {
+            if (static_cast<wide_type>(value) > static_cast<wide_type>(std::numeric_limits<std::int64_t>::max()))
+            {
+                magnitude mag {static_cast<limb_type>(value), static_cast<limb_type>(static_cast<wide_type>(value) >> limb_bits)};
+                assign_mag(false, mag);
+                return;
+            }
+        }
+        small_ = static_cast<std::int64_t>(value);
+    }
+
+    // decimal number with optional sign
+    explicit BigInt(std::string_view str)
+    {
+        bool neg = !str.empty() && str.front() == '-';
+        if (!str.empty() && (str.front() == '-' || str.front() == '+'))
+            str.remove_prefix(1);
+        if (str.empty())
+            throw std::invalid_argument{"BigInt from string without digits"};
+
+        for (std::size_t pos = 0; pos < str.size();)
+        {
+            std::size_t len = std::min<std::size_t>(9, str.size() - pos);
+            limb_type chunk = 0, scale = 1;
+            for (std::size_t i = 0; i < len; i++, pos++)
+            {
+                if (str[pos] < '0' || str[pos] > '9')
+                    throw std::invalid_argument{"BigInt from string with not digit"};
+                chunk = chunk * 10 + static_cast<limb_type>(str[pos] - '0');
+                scale *= 10;
+            }
+            *this *= BigInt{scale};
+            *this += BigInt{chunk};
+        }
+        if (neg)
+            *this = -*this;
+    }
+//--------------------------------=| Ctors end |=-------------------------------------------------------
+
+//--------------------------------=| Observers start |=-------------------------------------------------
+    bool is_small() const {return mag_.empty();}
+
+    // number of 32 bit limbs of absolute value
+    std::size_t limbs() const {return Limbs{*this}.size;}
+
+    int sign() const
+    {
+        if (is_small())
+            return (small_ > 0) - (small_ < 0);
+        return neg_ ? -1 : 1;
+    }
+
+    explicit operator bool() const {return sign() != 0;}
+
+    std::string to_string() const
+    {
+        if (is_small())
+            return std::to_string(small_);
+
+        magnitude mag = mag_;
+        std::string res;
+        constexpr limb_type chunk_base = 1'000'000'000;
+        while (!mag.empty())
+        {
+            wide_type carry = 0;
+            for (std::size_t i = mag.size(); i-- > 0;)
+            {
+                wide_type cur = (carry << limb_bits) | mag[i];
+                mag[i] = static_cast<limb_type>(cur / chunk_base);
+                carry = cur % chunk_base;
+            }
+            trim(mag);
+            for (int i = 0; i < 9 && (carry != 0 || !mag.empty()); i++, carry /= 10)
+                res.push_back(static_cast<char>('0' + carry % 10));
+        }
+        if (neg_)
+            res.push_back('-');
+        std::reverse(res.begin(), res.end());
+        return res;
+    }
+//--------------------------------=| Observers end |=---------------------------------------------------
+
+//--------------------------------=| Arithmetic start |=------------------------------------------------
+    BigInt operator-() const
+    {
+        BigInt res {*this};
+        if (!res.is_small())
+            res.neg_ = !res.neg_;
+        else if (res.small_ != std::numeric_limits<std::int64_t>::min())
+            res.small_ = -res.small_;
+        else
+        {
+            Limbs limbs {*this};
+            magnitude mag (limbs.ptr, limbs.ptr + limbs.size);
+            res.assign_mag(false, mag);
+        }
+        return res;
+    }
+
+    BigInt& operator+=(const BigInt& rhs)
+    {
+        std::int64_t sum;
+        if (is_small() && rhs.is_small() && !__builtin_add_overflow(small_, rhs.small_, &sum))
+        {
+            small_ = sum;
+            return *this;
+        }
+        Limbs b {rhs};
+        Limbs a {*this};
+        assign_sum(a, b.ptr, b.size, b.neg);
+        return *this;
+    }
+
+    BigInt& operator-=(const BigInt& rhs)
+    {
+        std::int64_t diff;
+        if (is_small() && rhs.is_small() && !__builtin_sub_overflow(small_, rhs.small_, &diff))
+        {
+            small_ = diff;
+            return *this;
+        }
+        Limbs b {rhs};
+        Limbs a {*this};
+        assign_sum(a, b.ptr, b.size, !b.neg && b.size != 0);
+        return *this;
+    }
+
+    BigInt& operator*=(const BigInt& rhs)
+    {
+        std::int64_t prod;
+        if (is_small() && rhs.is_small() && !__builtin_mul_overflow(small_, rhs.small_, &prod))
+        {
+            small_ = prod;
+            return *this;
+        }
+        Limbs a {*this}, b {rhs};
+        auto& res = scratch(0);
+        mul_mag(a.ptr, a.size, b.ptr, b.size, res);
+        assign_mag(a.neg != b.neg, res);
+        return *this;
+    }
+
+    // truncating division like for built in integers, remainder has sign of dividend
+    static std::pair<BigInt, BigInt> divmod(const BigInt& lhs, const BigInt& rhs)
+    {
+        if (!rhs)
+            throw std::invalid_argument{"BigInt division by zero"};
+        if (lhs.is_small() && rhs.is_small() &&
+            !(lhs.small_ == std::numeric_limits<std::int64_t>::min() && rhs.small_ == -1))
+            return {BigInt{lhs.small_ / rhs.small_}, BigInt{lhs.small_ % rhs.small_}};
+
+        Limbs a {lhs}, b {rhs};
+        auto& quot = scratch(1);
+        auto& rem = scratch(2);
+        divmod_mag(a.ptr, a.size, b.ptr, b.size, quot, rem);
+        std::pair<BigInt, BigInt> res;
+        res.first.assign_mag(a.neg != b.neg, quot);
+        res.second.assign_mag(a.neg, rem);
+        return res;
+    }
+
+    BigInt& operator/=(const BigInt& rhs)
+    {
+        if (is_small() && rhs.is_small() && rhs.small_ != 0 && rhs.small_ != -1)
+        {
+            small_ /= rhs.small_;
+            return *this;
+        }
+        return *this = divmod(*this, rhs).first;
+    }
+
+    BigInt& operator%=(const BigInt& rhs)
+    {
+        if (is_small() && rhs.is_small() && rhs.small_ != 0 && rhs.small_ != -1)
+        {
+            small_ %= rhs.small_;
+            return *this;
+        }
+        return *this = divmod(*this, rhs).second;
+    }
+
+    // this -= a * b
+    void fused_mul_sub(const BigInt& a, const BigInt& b)
+    {
+        std::int64_t prod, diff;
+        if (is_small() && a.is_small() && b.is_small() &&
+            !__builtin_mul_overflow(a.small_, b.small_, &prod) && !__builtin_sub_overflow(small_, prod, &diff))
+        {
+            small_ = diff;
+            return;
+        }
+        Limbs la {a}, lb {b};
+        auto& prod_mag = scratch(1);
+        mul_mag(la.ptr, la.size, lb.ptr, lb.size, prod_mag);
+        bool prod_neg = (la.neg != lb.neg) && !prod_mag.empty();
+        Limbs self {*this};
+        assign_sum(self, prod_mag.data(), prod_mag.size(), !prod_neg && !prod_mag.empty());
+    }
+
+    // this = (this * d - b * c) / div, division has to be exact (step of Bareiss algorithm)
+    void mul_sub_div(const BigInt& d, const BigInt& b, const BigInt& c, const BigInt& div)
+    {
+        if (!div)
+            throw std::invalid_argument{"BigInt division by zero"};
+#if defined(__SIZEOF_INT128__)
+        if (is_small() && d.is_small() && b.is_small() && c.is_small() && div.is_small())
+        {
+            __extension__ using int128 = __int128;
+            int128 res = (int128{small_} * d.small_ - int128{b.small_} * c.small_) / div.small_;
+            if (res >= std::numeric_limits<std::int64_t>::min() && res <= std::numeric_limits<std::int64_t>::max())
+            {
+                small_ = static_cast<std::int64_t>(res);
+                return;
+            }
+        }
+#endif
+        auto& lhs_mag = scratch(0);
+        auto& rhs_mag = scratch(1);
+        auto& diff_mag = scratch(2);
+        bool lhs_neg, rhs_neg;
+        {
+            Limbs x {*this}, ld {d};
+            mul_mag(x.ptr, x.size, ld.ptr, ld.size, lhs_mag);
+            lhs_neg = x.neg != ld.neg;
+        }
+        {
+            Limbs lb {b}, lc {c};
+            mul_mag(lb.ptr, lb.size, lc.ptr, lc.size, rhs_mag);
+            rhs_neg = lb.neg != lc.neg;
+        }
+
+        // diff = lhs - rhs
+        bool diff_neg;
+        if (lhs_neg != rhs_neg)
+        {
+            add_mag(lhs_mag.data(), lhs_mag.size(), rhs_mag.data(), rhs_mag.size(), diff_mag);
+            diff_neg = lhs_neg;
+        }
+        else if (compare_mag(lhs_mag.data(), lhs_mag.size(), rhs_mag.data(), rhs_mag.size()) >= 0)
+        {
+            sub_mag(lhs_mag.data(), lhs_mag.size(), rhs_mag.data(), rhs_mag.size(), diff_mag);
+            diff_neg = lhs_neg;
+        }
+        else
+        {
+            sub_mag(rhs_mag.data(), rhs_mag.size(), lhs_mag.data(), lhs_mag.size(), diff_mag);
+            diff_neg = !rhs_neg;
+        }
+
+        Limbs ldiv {div};
+        divmod_mag(diff_mag.data(), diff_mag.size(), ldiv.ptr, ldiv.size, lhs_mag, rhs_mag);
+        assign_mag(diff_neg != ldiv.neg, lhs_mag);
+    }
+
+    friend BigInt abs(const BigInt& value) {return (value.sign() < 0) ? -value : value;}
+
+    friend BigInt gcd(const BigInt& lhs, const BigInt& rhs)
+    {
+        BigInt a = abs(lhs), b = abs(rhs);
+        while (!(a.is_small() && b.is_small()))
+        {
+            if (!b)
+                return a;
+            a = divmod(a, b).second;
+            std::swap(a, b);
+        }
+        return BigInt{gcd_small(static_cast<std::uint64_t>(a.small_), static_cast<std::uint64_t>(b.small_))};
+    }
+//--------------------------------=| Arithmetic end |=--------------------------------------------------
+
+//--------------------------------=| Compare start |=---------------------------------------------------
+    friend bool operator==(const BigInt& lhs, const BigInt& rhs)
+    {
+        if (lhs.is_small() || rhs.is_small())
+            return lhs.is_small() && rhs.is_small() && lhs.small_ == rhs.small_;
+        return lhs.neg_ == rhs.neg_ && lhs.mag_ == rhs.mag_;
+    }
+
+    friend std::strong_ordering operator<=>(const BigInt& lhs, const BigInt& rhs)
+    {
+        if (lhs.is_small() && rhs.is_small())
+            return lhs.small_ <=> rhs.small_;
+        if (lhs.sign() != rhs.sign())
+            return lhs.sign() <=> rhs.sign();
+        Limbs a {lhs}, b {rhs};
+        int cmp = compare_mag(a.ptr, a.size, b.ptr, b.size);
+        if (a.neg)
+            cmp = -cmp;
+        return cmp <=> 0;
+    }
+//--------------------------------=| Compare end |=-----------------------------------------------------
+};
+
+inline BigInt operator+(BigInt lhs, const BigInt& rhs) {return lhs += rhs;}
+inline BigInt operator-(BigInt lhs, const BigInt& rhs) {return lhs -= rhs;}
+inline BigInt operator*(BigInt lhs, const BigInt& rhs) {return lhs *= rhs;}
+inline BigInt operator/(BigInt lhs, const BigInt& rhs) {return lhs /= rhs;}
+inline BigInt operator%(BigInt lhs, const BigInt& rhs) {return lhs %= rhs;}
+
+inline std::ostream& operator<<(std::ostream& os, const BigInt& value)
+{
+    return os << value.to_string();
+}
+
+class Rational
+{
+    // denominator is kept positive, fraction is reduced when it is cheap (both parts fit in int64)
+    // or when denominator becomes longer than lazy_limbs
+    static constexpr std::size_t lazy_limbs = 4;
+
+    BigInt num_ {0}, den_ {1};
+
+    void reduce_if_needed()
+    {
+        if ((num_.is_small() && den_.is_small()) || den_.limbs() > lazy_limbs)
+            reduce();
+    }
+
+public:
+//--------------------------------=| Ctors start |=-----------------------------------------------------
+    Rational() = default;
+
+    template<std::integral I>
+    Rational(I value): num_ {value} {}
+
+    Rational(BigInt value): num_ {std::move(value)} {}
+
+    Rational(BigInt num, BigInt den): num_ {std::move(num)}, den_ {std::move(den)}
+    {
+        if (!den_)
+            throw std::invalid_argument{"Rational with zero denominator"};
+        if (den_.sign() < 0)
+        {
+            num_ = -num_;
+            den_ = -den_;
+        }
+        reduce_if_needed();
+    }
+//--------------------------------=| Ctors end |=-------------------------------------------------------
+
+//--------------------------------=| Observers start |=-------------------------------------------------
+    // parts of fraction as it is stored, call reduce() before to get lowest terms
+    const BigInt& numerator()   const {return num_;}
+    const BigInt& denominator() const {return den_;}
+
+    void reduce()
+    {
+        auto common = gcd(num_, den_);
+        if (common != BigInt{1} && common)
+        {
+            num_ /= common;
+            den_ /= common;
+        }
+    }
+
+    int sign() const {return num_.sign();}
+
+    std::string to_string() const
+    {
+        Rational reduced {*this};
+        reduced.reduce();
+        if (reduced.den_ == BigInt{1})
+            return reduced.num_.to_string();
+        return reduced.num_.to_string() + '/' + reduced.den_.to_string();
+    }
+//--------------------------------=| Observers end |=---------------------------------------------------
+
+//--------------------------------=| Arithmetic start |=------------------------------------------------
+    Rational operator-() const
+    {
+        Rational res {*this};
+        res.num_ = -res.num_;
+        return res;
+    }
+
+    Rational& operator+=(const Rational& rhs)
+    {
+        if (den_ == rhs.den_)
+            num_ += rhs.num_;
+        else
+        {
+            num_ *= rhs.den_;
+            num_ += rhs.num_ * den_;
+            den_ *= rhs.den_;
+        }
+        reduce_if_needed();
+        return *this;
+    }
+
+    Rational& operator-=(const Rational& rhs)
+    {
+        if (den_ == rhs.den_)
+            num_ -= rhs.num_;
+        else
+        {
+            num_ *= rhs.den_;
+            num_.fused_mul_sub(rhs.num_, den_);
+            den_ *= rhs.den_;
+        }
+        reduce_if_needed();
+        return *this;
+    }
+
+    Rational& operator*=(const Rational& rhs)
+    {
+        num_ *= rhs.num_;
+        den_ *= rhs.den_;
+        reduce_if_needed();
+        return *this;
+    }
+
+    Rational& operator/=(const Rational& rhs)
+    {
+        if (!rhs.num_)
+            throw std::invalid_argument{"Rational division by zero"};
+        BigInt rhs_num = rhs.num_; // rhs may be *this
+        num_ *= rhs.den_;
+        den_ *= rhs_num;
+        if (den_.sign() < 0)
+        {
+            num_ = -num_;
+            den_ = -den_;
+        }
+        reduce_if_needed();
+        return *this;
+    }
+
+    // this -= a * b
+    void fused_mul_sub(const Rational& a, const Rational& b)
+    {
+        if (a.den_ == BigInt{1} && b.den_ == BigInt{1})
+        {
+            // x / d - a * b = (x - d * a * b) / d
+            BigInt prod = a.num_ * b.num_;
+            num_.fused_mul_sub(den_, prod);
+        }
+        else
+        {
+            BigInt prod_num = a.num_ * b.num_, prod_den = a.den_ * b.den_;
+            num_ *= prod_den;
+            num_.fused_mul_sub(prod_num, den_);
+            den_ *= prod_den;
+        }
+        reduce_if_needed();
+    }
+
+    friend Rational abs(const Rational& value) {return (value.sign() < 0) ? -value : value;}
+//--------------------------------=| Arithmetic end |=--------------------------------------------------
+
+//--------------------------------=| Compare start |=---------------------------------------------------
+    friend bool operator==(const Rational& lhs, const Rational& rhs)
+    {
+        if (lhs.den_ == rhs.den_)
+            return lhs.num_ == rhs.num_;
+        return lhs.num_ * rhs.den_ == rhs.num_ * lhs.den_;
+    }
+
+    friend std::strong_ordering operator<=>(const Rational& lhs, const Rational& rhs)
+    {
+        if (lhs.den_ == rhs.den_)
+            return lhs.num_ <=> rhs.num_;
+        return lhs.num_ * rhs.den_ <=> rhs.num_ * lhs.den_;
+    }
+//--------------------------------=| Compare end |=-----------------------------------------------------
+};
+
+inline Rational operator+(Rational lhs, const Rational& rhs) {return lhs += rhs;}
+inline Rational operator-(Rational lhs, const Rational& rhs) {return lhs -= rhs;}
+inline Rational operator*(Rational lhs, const Rational& rhs) {return lhs *= rhs;}
+inline Rational operator/(Rational lhs, const Rational& rhs) {return lhs /= rhs;}
+
+inline std::ostream& operator<<(std::ostream& os, const Rational& value)
+{
+    return os << value.to_string();
+}
+
+namespace detail
+{
+
+template<>
+struct DefaultAbs<BigInt>
+{
+    BigInt operator()(const BigInt& arg) const {return abs(arg);}
+};
+
+template<>
+struct DefaultAbs<Rational>
+{
+    Rational operator()(const Rational& arg) const {return abs(arg);}
+};
+
+} // namespace detail
+
+/*
+ * Gauss elimination over fractions has to reduce every element on every step. If denominators
+ * are short, every row is multiplied by lcm of its denominators and determinant of integer matrix
+ * is found by Bareiss algorithm, where all intermediate values are minors:
+ * det = det(integer matrix) / product of lcm. With long lcm (Hilbert like matrices) scaled integers
+ * are too long and std::nullopt is returned: Gauss elimination is faster there.
+ */
+template<class Cmp, class Abs>
+std::optional<Rational> fraction_free_determinant(const MatrixArithmetic<Rational, true, Cmp, Abs>& mat)
+{
+    constexpr std::size_t max_lcm_limbs = 2;
+
+    MATRIX_PROFILE_SCOPE("fraction_free_determinant");
+    MatrixArithmetic<BigInt> integers (mat.height(), mat.width());
+    BigInt scale {1};
+    for (std::size_t i = 0; i < mat.height(); i++)
+    {
+        BigInt row_lcm {1};
+        for (const auto& elem: mat[i])
+        {
+            row_lcm = row_lcm / gcd(row_lcm, elem.denominator()) * elem.denominator();
+            if (row_lcm.limbs() > max_lcm_limbs)
+                return std::nullopt;
+        }
+        for (std::size_t j = 0; j < mat.width(); j++)
+            integers.to(i, j) = mat.to(i, j).numerator() * (row_lcm / mat.to(i, j).denominator());
+        scale *= row_lcm;
+    }
+    return Rational{integers.determinant(), scale};
+}
+
+} // namespace Matrix
@@ -0,0 +1,435 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "matrix_arithmetic.hpp"
+#include "matrix_parallel.hpp"
+#include "matrix_reduce.hpp"
+#include "matrix_storage.hpp"
+#include "matrix_strassen.hpp"
+#include "matrix_vector.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Matrix exponential for floating point matrices.                              |
+ * expm(): Pade approximant of degree 3, 5, 7, 9 or 13 with scaling and         |
+ * squaring (Higham 2005), degree is chosen by ||A||_1 so that backward error   |
+ * is on level of double precision with minimal number of products. All         |
+ * products go by Strassen-Winograd kernel on padded buffers of one workspace,  |
+ * which is allocated once per call. Denominator is factorized in place by      |
+ * blocked LU with partial pivoting, numerator is solved by chunks of columns   |
+ * in parallel.                                                                 |
+ * expm_multiply(): exp(t * A) * v without forming exponential by truncated     |
+ * Taylor series with scaling (Al-Mohy, Higham 2011), costs matrix-vector       |
+ * products only.                                                               |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+namespace detail
+{
+
+// coefficients b_0..b_m of Pade approximants of exp
+constexpr double pade_3[]  = {120.0, 60.0, 12.0, 1.0};
+constexpr double pade_5[]  = {30240.0, 15120.0, 3360.0, 420.0, 30.0, 1.0};
+constexpr double pade_7[]  = {17297280.0, 8648640.0, 1995840.0, 277200.0, 25200.0, 1512.0, 56.0, 1.0};
+constexpr double pade_9[]  = {17643225600.0, 8821612800.0, 2075673600.0, 302702400.0, 30270240.0,
+                              2162160.0, 110880.0, 3960.0, 90.0, 1.0};
+constexpr double pade_13[] = {64764752532480000.0, 32382376266240000.0, 7771770303897600.0,
+                              1187353796428800.0, 129060195264000.0, 10559470521600.0, 670442572800.0,
+                              33522128640.0, 1323241920.0, 40840800.0, 960960.0, 16380.0, 182.0, 1.0};
+
+// max ||A||_1 for which Pade approximant of degree 3, 5, 7, 9, 13 has backward error <= 2^-53
+constexpr double pade_theta[] = {1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1,
+                                 2.097847961257068e0, 5.371920351148152e0};
+
+// degrees of Taylor polynomial and max ||A||_1 for them with error <= 2^-53 (Al-Mohy, Higham 2011)
+constexpr std::pair<std::size_t, double> taylor_theta[] = {
+    {1, 2.29e-16}, {2, 2.58e-8}, {3, 1.39e-5}, {4, 3.40e-4}, {5, 2.40e-3}, {6, 9.07e-3}, {7, 2.38e-2},
+    {8, 5.00e-2}, {9, 8.96e-2}, {10, 1.44e-1}, {11, 2.14e-1}, {12, 3.00e-1}, {13, 4.00e-1}, {14, 5.14e-1},
+    {15, 6.41e-1}, {16, 7.81e-1}, {17, 9.31e-1}, {18, 1.09}, {19, 1.26}, {20, 1.44}, {21, 1.62},
+    {22, 1.82}, {23, 2.01}, {24, 2.22}, {25, 2.43}, {26, 2.64}, {27, 2.86}, {28, 3.08}, {29, 3.31},
+    {30, 3.54}, {35, 4.7}, {40, 6.0}, {45, 7.2}, {50, 8.5}, {55, 9.9}};
+
+/*
+ * Buffers of scaling and squaring: powers of A, numerator U, denominator V and one
+ * temporary. Every buffer is padded x padded with zeros outside of n x n, so products
+ * go by Strassen-Winograd kernel without repacking and padding stays zero.
+ */
+template<typename T>
+class ExpmWorkspace
+{
+    using size_type = std::size_t;
+    using buffer    = aligned_vector<T>;
+    using view      = BlockView<T>;
+
+    size_type n_, padded_, ld_, depth_;
+    StrassenWinograd<T> gemm_;
+    std::vector<buffer> powers_; // A, A^2, A^4, A^6, A^8
+    buffer u_, v_, tmp_;
+    std::vector<size_type> pivots_;
+
+    static constexpr size_type lu_block = 32;
+
+    view as_view(buffer& buf) {return {buf.data(), ld_};}
+
+    // dst = lhs * rhs, without recursion of Strassen-Winograd chunks of rows go in parallel
+    void multiply(buffer& dst, buffer& lhs, buffer& rhs)
+    {
+        if (depth_ == 0)
+            parallel_for(0, n_, [&](size_type first, size_type last)
+            {
+                StrassenWinograd<T> {0}(as_view(lhs).sub(first, 0), as_view(rhs), as_view(dst).sub(first, 0),
+                                        last - first, n_, n_, 0);
+            }, rows_per_chunk(n_ * n_));
+        else
+            gemm_(as_view(lhs), as_view(rhs), as_view(dst), padded_, padded_, padded_, depth_);
+        MATRIX_PROFILE_FLOPS(2 * n_ * n_ * n_);
+    }
+
+    // dst = (is_accumulated ? dst : 0) + eye_coef * I + sum of coef * powers_[ind]
+    void combine(buffer& dst, bool is_accumulated, T eye_coef, std::initializer_list<std::pair<T, size_type>> terms)
+    {
+        parallel_for(0, n_, [&](size_type first, size_type last)
+        {
+            for (size_type i = first; i < last; i++)
+            {
+                T* dst_row = dst.data() + i * ld_;
+                if (!is_accumulated)
+                    std::fill(dst_row, dst_row + n_, T{});
+                for (const auto& [coef, ind]: terms)
+                {
+                    const T* src_row = powers_[ind].data() + i * ld_;
+                    for (size_type j = 0; j < n_; j++)
+                        dst_row[j] += coef * src_row[j];
+                }
+                dst_row[i] += eye_coef;
+            }
+        }, rows_per_chunk(n_));
+    }
+
+    T* row(buffer& buf, size_type i) {return buf.data() + i * ld_;}
+
+    // tmp_ = P * L * U by panels of lu_block columns: panel is factorized with row swaps over whole rows,
+    // then U12 = L11^{-1} * A12 and trailing rows A22 -= L21 * U12 go in parallel
+    void factorize_denominator()
+    {
+        for (size_type k0 = 0; k0 < n_; k0 += lu_block)
+        {
+            const size_type k_end = std::min(n_, k0 + lu_block);
+            for (size_type k = k0; k < k_end; k++)
+            {
+                size_type pivot = k;
+                for (size_type i = k + 1; i < n_; i++)
+                    if (std::abs(row(tmp_, i)[k]) > std::abs(row(tmp_, pivot)[k]))
+                        pivot = i;
+                if (row(tmp_, pivot)[k] == T{})
+                    throw std::invalid_argument{"in expm: denominator of Pade approximant is singular"};
+                pivots_[k] = pivot;
+                if (pivot != k)
+                    std::swap_ranges(row(tmp_, k), row(tmp_, k) + n_, row(tmp_, pivot));
+
+                const T* row_k = row(tmp_, k);
+                for (size_type i = k + 1; i < n_; i++)
+                {
+                    T* row_i = row(tmp_, i);
+                    T coef = row_i[k] /= row_k[k];
+                    for (size_type j = k + 1; j < k_end; j++)
+                        row_i[j] -= coef * row_k[j];
+                }
+            }
+            if (k_end == n_)
+                break;
+
+            for (size_type k = k0; k < k_end; k++)
+                for (size_type i = k + 1; i < k_end; i++)
+                {
+                    T* row_i = row(tmp_, i);
+                    const T* row_k = row(tmp_, k);
+                    for (size_type j = k_end; j < n_; j++)
+                        row_i[j] -= row_i[k] * row_k[j];
+                }
+            parallel_for(k_end, n_, [&](size_type first, size_type last)
+            {
+                for (size_type i = first; i < last; i++)
+                {
+                    T* row_i = row(tmp_, i);
+                    for (size_type k = k0; k < k_end; k++)
+                    {
+                        const T coef = row_i[k];
+                        const T* row_k = row(tmp_, k);
+                        for (size_type j = k_end; j < n_; j++)
+                            row_i[j] -= coef * row_k[j];
+                    }
+                }
+            }, rows_per_chunk((n_ - k_end) * (k_end - k0)));
+        }
+        MATRIX_PROFILE_FLOPS(2 * n_ * n_ * n_ / 3);
+    }
+
+    // u_ = (V - U)^{-1} * (V + U): V - U is factorized in place in tmp_, V + U is built in u_ and
+    // goes through row swaps and both triangular solves by chunks of columns in parallel
+    void solve_pade()
+    {
+        parallel_for(0, n_, [&](size_type first, size_type last)
+        {
+            for (size_type i = first; i < last; i++)
+            {
+                T* u_row = row(u_, i);
+                T* d_row = row(tmp_, i);
+                const T* v_row = row(v_, i);
+                for (size_type j = 0; j < n_; j++)
+                {
+                    d_row[j] = v_row[j] - u_row[j];
+                    u_row[j] += v_row[j];
+                }
+            }
+        }, rows_per_chunk(n_));
+        factorize_denominator();
+
+        parallel_for(0, n_, [&](size_type first, size_type last)
+        {
+            for (size_type k = 0; k < n_; k++)
+                if (pivots_[k] != k)
+                    std::swap_ranges(row(u_, k) + first, row(u_, k) + last, row(u_, pivots_[k]) + first);
+            for (size_type i = 1; i < n_; i++)
+            {
+                T* u_i = row(u_, i);
+                const T* lu_i = row(tmp_, i);
+                for (size_type k = 0; k < i; k++)
+                {
+                    const T* u_k = row(u_, k);
+                    for (size_type j = first; j < last; j++)
+                        u_i[j] -= lu_i[k] * u_k[j];
+                }
+            }
+            for (size_type i = n_ - 1; static_cast<long long>(i) >= 0; i--)
+            {
+                T* u_i = row(u_, i);
+                const T* lu_i = row(tmp_, i);
+                for (size_type k = i + 1; k < n_; k++)
+                {
+                    const T* u_k = row(u_, k);
+                    for (size_type j = first; j < last; j++)
+                        u_i[j] -= lu_i[k] * u_k[j];
+                }
+                for (size_type j = first; j < last; j++)
+                    u_i[j] /= lu_i[i];
+            }
+        }, std::max<size_type>(16, rows_per_chunk(n_ * n_)));
+        MATRIX_PROFILE_FLOPS(2 * n_ * n_ * n_);
+    }
+
+public:
+    template<typename Mat>
+    ExpmWorkspace(const Mat& mat, int scale_pow, const StrassenParams& params, size_type powers_num)
+    :n_ {mat.height()}, depth_ {0}, gemm_ {params.parallel_depth}
+    {
+        size_type cutoff = std::max<size_type>(params.cutoff, 1);
+        for (size_type side = n_; side > cutoff; side = (side + 1) / 2)
+            depth_++;
+        padded_ = ((n_ + (size_type{1} << depth_) - 1) >> depth_) << depth_;
+        ld_ = padded_stride<T>(padded_);
+
+        powers_.assign(powers_num, buffer(padded_ * ld_));
+        u_.resize(padded_ * ld_);
+        v_.resize(padded_ * ld_);
+        tmp_.resize(padded_ * ld_);
+        pivots_.resize(n_);
+        MATRIX_PROFILE_TEMPORARY((powers_num + 3) * padded_ * ld_ * sizeof(T) + n_ * sizeof(size_type));
+
+        for (size_type i = 0; i < n_; i++)
+            for (size_type j = 0; j < n_; j++)
+                powers_[0][i * ld_ + j] = std::ldexp(mat.to(i, j), -scale_pow);
+    }
+
+    // u_ = r_m(A) for m in {3, 5, 7, 9}
+    void pade(const double* b, size_type m)
+    {
+        multiply(powers_[1], powers_[0], powers_[0]);
+        for (size_type p = 2; p < powers_.size(); p++)
+            multiply(powers_[p], powers_[p - 1], powers_[1]);
+
+        // U = A * (b_1 I + b_3 A^2 + ...), V = b_0 I + b_2 A^2 + ...
+        combine(tmp_, false, T(b[1]), {});
+        combine(v_, false, T(b[0]), {});
+        for (size_type p = 1; 2 * p <= m; p++)
+        {
+            combine(tmp_, true, T{}, {{T(b[2 * p + 1]), p}});
+            combine(v_, true, T{}, {{T(b[2 * p]), p}});
+        }
+        multiply(u_, powers_[0], tmp_);
+        solve_pade();
+    }
+
+    // u_ = r_13(A)
+    void pade_13()
+    {
+        const double* b = detail::pade_13;
+        multiply(powers_[1], powers_[0], powers_[0]);
+        multiply(powers_[2], powers_[1], powers_[1]);
+        multiply(powers_[3], powers_[2], powers_[1]);
+
+        // U = A * (A^6 * (b_13 A^6 + b_11 A^4 + b_9 A^2) + b_7 A^6 + b_5 A^4 + b_3 A^2 + b_1 I)
+        combine(tmp_, false, T{}, {{T(b[13]), 3}, {T(b[11]), 2}, {T(b[9]), 1}});
+        multiply(v_, powers_[3], tmp_);
+        combine(v_, true, T(b[1]), {{T(b[7]), 3}, {T(b[5]), 2}, {T(b[3]), 1}});
+        multiply(u_, powers_[0], v_);
+
+        // V = A^6 * (b_12 A^6 + b_10 A^4 + b_8 A^2) + b_6 A^6 + b_4 A^4 + b_2 A^2 + b_0 I
+        combine(tmp_, false, T{}, {{T(b[12]), 3}, {T(b[10]), 2}, {T(b[8]), 1}});
+        multiply(v_, powers_[3], tmp_);
+        combine(v_, true, T(b[0]), {{T(b[6]), 3}, {T(b[4]), 2}, {T(b[2]), 1}});
+        solve_pade();
+    }
+
+    // u_ = u_ * u_, buffers are swapped, nothing is allocated
+    void square()
+    {
+        multiply(tmp_, u_, u_);
+        std::swap(u_, tmp_);
+    }
+
+    template<typename Mat>
+    void result(Mat& res) const
+    {
+        for (size_type i = 0; i < n_; i++)
+            std::copy(u_.begin() + i * ld_, u_.begin() + i * ld_ + n_, res[i].begin());
+    }
+};
+
+} // namespace detail
+
+// exp(mat), params set kernel of products (see matrix_strassen.hpp)
+template<std::floating_point T, bool IsDivArithm, class Cmp, class Abs>
+MatrixArithmetic<T, IsDivArithm, Cmp, Abs> expm(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat,
+                                                const StrassenParams& params = {})
+{
+    if (!mat.is_square())
+        throw std::invalid_argument{"try to get exponential of no square matrix"};
+
+    MATRIX_PROFILE_SCOPE("expm");
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> res (mat.height(), mat.width());
+    if (mat.is_empty())
+        return res;
+
+    double norm = static_cast<double>(norm_1(mat));
+    if (!std::isfinite(norm))
+        throw std::invalid_argument{"try to get exponential of matrix with not finite elements"};
+
+    constexpr const double* pade_low[] = {detail::pade_3, detail::pade_5, detail::pade_7, detail::pade_9};
+    for (std::size_t ind = 0; ind < std::size(pade_low); ind++)
+        if (norm <= detail::pade_theta[ind])
+        {
+            // A^2, ..., A^(m - 1) are needed
+            detail::ExpmWorkspace<T> ws {mat, 0, params, ind + 2};
+            ws.pade(pade_low[ind], 2 * ind + 3);
+            ws.result(res);
+            return res;
+        }
+
+    int scale_pow = std::max(0, static_cast<int>(std::ceil(std::log2(norm / detail::pade_theta[4]))));
+    detail::ExpmWorkspace<T> ws {mat, scale_pow, params, 4};
+    ws.pade_13();
+    for (int i = 0; i < scale_pow; i++)
+        ws.square();
+    ws.result(res);
+    return res;
+}
+
+// exp(t * mat) * vec, costs only products of mat and vectors
+template<std::floating_point T, bool IsDivArithm, class Cmp, class Abs>
+DenseVector<T> expm_multiply(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat, const DenseVector<T>& vec, T t = T{1})
+{
+    if (!mat.is_square())
+        throw std::invalid_argument{"try to get exponential of no square matrix"};
+    if (mat.width() != vec.size())
+        throw std::invalid_argument{"in expm_multiply: mat.width() != vec.size()"};
+
+    MATRIX_PROFILE_SCOPE("expm_multiply");
+    const std::size_t n = mat.height();
+    if (n == 0)
+        return vec;
+
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> shifted = mat * t;
+    double norm = static_cast<double>(norm_1(shifted));
+    if (!std::isfinite(norm))
+        throw std::invalid_argument{"try to get exponential of matrix with not finite elements"};
+
+    // shift by mean of diagonal is kept only if ||A - mu I||_1 < ||A||_1, exp(mu) is returned back by multiplication
+    T mu = t * trace(mat) / static_cast<T>(n);
+    std::vector<T> diag (n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        diag[i] = shifted.to(i, i);
+        shifted.to(i, i) -= mu;
+    }
+    double shifted_norm = static_cast<double>(norm_1(shifted));
+    if (shifted_norm < norm)
+        norm = shifted_norm;
+    else
+    {
+        for (std::size_t i = 0; i < n; i++)
+            shifted.to(i, i) = diag[i];
+        mu = T{};
+    }
+
+    // degree m and number of steps s with minimal number m * s of products
+    std::size_t degree = 0, steps = 1;
+    if (norm > 0)
+    {
+        double best_cost = std::numeric_limits<double>::infinity();
+        for (const auto& [m, theta]: detail::taylor_theta)
+        {
+            double s = std::max(1.0, std::ceil(norm / theta));
+            if (m * s < best_cost)
+            {
+                best_cost = m * s;
+                degree = m;
+                steps = static_cast<std::size_t>(s);
+            }
+        }
+    }
+
+    auto norm_inf = [](const DenseVector<T>& x)
+    {
+        T res {};
+        for (auto elem: x)
+            res = std::max(res, std::abs(elem));
+        return res;
+    };
+
+    const T tol = std::numeric_limits<T>::epsilon();
+    const T eta = std::exp(mu / static_cast<T>(steps));
+    DenseVector<T> res {vec}, term {vec}, next (n);
+    for (std::size_t step = 0; step < steps; step++)
+    {
+        T prev_norm = norm_inf(term);
+        for (std::size_t j = 1; j <= degree; j++)
+        {
+            detail::gemv_kernel(shifted, term.data(), next.data());
+            next *= T{1} / static_cast<T>(steps * j);
+            std::swap(term, next);
+            res += term;
+            MATRIX_PROFILE_FLOPS(2 * n * n);
+
+            // two successive terms are negligible
+            T term_norm = norm_inf(term);
+            if (prev_norm + term_norm <= tol * norm_inf(res))
+                break;
+            prev_norm = term_norm;
+        }
+        res *= eta;
+        std::copy(res.begin(), res.end(), term.begin());
+    }
+    return res;
+}
+
+} // namespace Matrix
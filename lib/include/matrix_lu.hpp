@@ -0,0 +1,384 @@
+#pragma once
+#include "matrix_arithmetic.hpp"
+
+namespace Matrix
+{
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * LU factorization with partial pivoting: P * A = L * U.                        |
+ * Rows are never moved, row i of P * A is row permutation()[i] of A.           |
+ * L (unit lower) and U are packed in one matrix in original order of rows.     |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+class LUDecomposition
+{
+    static_assert(IsDivArithm, "LU factorization needs arithmetical division");
+
+public:
+    using matrix_type      = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+    using size_type        = typename matrix_type::size_type;
+    using value_type       = typename matrix_type::value_type;
+    using permutation_type = typename matrix_type::permutation_type;
+    using abs_type         = detail::abs_type<T, Abs>;
+
+private:
+    matrix_type lu_;
+    permutation_type perm_;
+    value_type sign_ {1};
+    Cmp cmp_ {};
+    Abs abs_ {};
+
+    // x = A^{-1} * x in O(n^2)
+    void solve_in_place(std::vector<value_type>& x) const
+    {
+        std::vector<value_type> y (size());
+        for (size_type i = 0; i < size(); i++)
+            y[i] = x[perm_[i]];
+        for (size_type i = 0; i < size(); i++)
+        {
+            const auto& row = lu_[perm_[i]];
+            for (size_type k = 0; k < i; k++)
+                detail::fused_mul_sub(y[i], row[k], y[k]);
+        }
+        for (size_type i = size() - 1; static_cast<long long>(i) >= 0; i--)
+        {
+            const auto& row = lu_[perm_[i]];
+            for (size_type k = i + 1; k < size(); k++)
+                detail::fused_mul_sub(y[i], row[k], y[k]);
+            y[i] /= row[i];
+        }
+        x = std::move(y);
+    }
+
+    // x = A^{-T} * x in O(n^2): A^T = U^T * L^T * P, both triangular solves go by rows of packed matrix
+    void solve_transposed_in_place(std::vector<value_type>& x) const
+    {
+        for (size_type k = 0; k < size(); k++)
+        {
+            const auto& row = lu_[perm_[k]];
+            x[k] /= row[k];
+            for (size_type i = k + 1; i < size(); i++)
+                detail::fused_mul_sub(x[i], row[i], x[k]);
+        }
+        for (size_type k = size() - 1; static_cast<long long>(k) >= 0; k--)
+        {
+            const auto& row = lu_[perm_[k]];
+            for (size_type i = 0; i < k; i++)
+                detail::fused_mul_sub(x[i], row[i], x[k]);
+        }
+        std::vector<value_type> res (size());
+        for (size_type i = 0; i < size(); i++)
+            res[perm_[i]] = x[i];
+        x = std::move(res);
+    }
+
+    abs_type vector_norm_1(const std::vector<value_type>& x) const
+    {
+        abs_type res {};
+        for (const auto& elem: x)
+            res += abs_(elem);
+        return res;
+    }
+
+    size_type argmax_abs(const std::vector<value_type>& x) const
+    {
+        size_type res = 0;
+        for (size_type i = 1; i < x.size(); i++)
+            if (abs_(x[res]) < abs_(x[i]))
+                res = i;
+        return res;
+    }
+
+    // x / |x|, 1 for zero
+    value_type sign_of(const value_type& elem) const
+    {
+        auto elem_abs = abs_(elem);
+        if (elem_abs == abs_type{})
+            return value_type{1};
+        return elem / static_cast<value_type>(elem_abs);
+    }
+
+public:
+    explicit LUDecomposition(const matrix_type& mat)
+    :lu_ {mat}, perm_ {matrix_type::identity_permutation(mat.height())}
+    {
+        if (!mat.is_square())
+            throw std::invalid_argument{"try to get LU factorization of no square matrix"};
+
+        if (mat.is_empty())
+            return;
+
+        if (mat.height() >= matrix_type::parallel_elimination_threshold)
+            sign_ = lu_.make_upper_triangular_square_parallel(mat.height(), perm_, detail::hardware_threads());
+        else
+            sign_ = lu_.make_upper_triangular_square(mat.height(), perm_);
+    }
+
+    size_type size() const {return lu_.height();}
+
+    const permutation_type& permutation() const {return perm_;}
+
+    // sign of permutation: 1 or -1
+    value_type sign() const {return sign_;}
+
+    // element (i, j) of packed L and U in permuted order
+    const value_type& packed(size_type i, size_type j) const {return lu_.to(perm_[i], j);}
+
+    bool is_singular() const
+    {
+        for (size_type i = 0; i < size(); i++)
+            if (cmp_(packed(i, i), value_type{}))
+                return true;
+        return false;
+    }
+
+    value_type determinant() const
+    {
+        return sign_ * lu_.determinant_for_upper_triangular(size(), perm_);
+    }
+
+    matrix_type lower() const
+    {
+        matrix_type res (size(), size());
+        for (size_type i = 0; i < size(); i++)
+        {
+            for (size_type j = 0; j < i; j++)
+                res.to(i, j) = packed(i, j);
+            res.to(i, i) = value_type{1};
+        }
+        return res;
+    }
+
+    // solve A * X = B for every column of B
+    matrix_type solve(const matrix_type& rhs) const
+    {
+        if (rhs.height() != size())
+            throw std::invalid_argument{"in solve: rhs.height() != size of factorized matrix"};
+        if (is_singular())
+            throw std::invalid_argument{"try to solve system with singular matrix"};
+
+        MATRIX_PROFILE_SCOPE("lu_solve");
+        matrix_type res (size(), rhs.width(), lu_.allocation());
+        for (size_type i = 0; i < size(); i++)
+            res[i] = rhs[perm_[i]];
+
+        // L * Y = P * B
+        for (size_type i = 0; i < size(); i++)
+        {
+            auto& res_i = res[i];
+            for (size_type k = 0; k < i; k++)
+            {
+                auto coef = packed(i, k);
+                const auto& res_k = res[k];
+                for (size_type j = 0; j < res.width(); j++)
+                    detail::fused_mul_sub(res_i[j], coef, res_k[j]);
+            }
+        }
+        // U * X = Y
+        for (size_type i = size() - 1; static_cast<long long>(i) >= 0; i--)
+        {
+            auto& res_i = res[i];
+            for (size_type k = i + 1; k < size(); k++)
+            {
+                auto coef = packed(i, k);
+                const auto& res_k = res[k];
+                for (size_type j = 0; j < res.width(); j++)
+                    detail::fused_mul_sub(res_i[j], coef, res_k[j]);
+            }
+            auto diag = packed(i, i);
+            for (auto& elem: res_i)
+                elem /= diag;
+        }
+        MATRIX_PROFILE_FLOPS(2 * size() * size() * rhs.width());
+        return res;
+    }
+
+    matrix_type inverse() const
+    {
+        return solve(matrix_type::eye(size()));
+    }
+
+    /*
+     * Estimate of ||A^{-1}||_1 without inverse by Hager method with Higham refinements
+     * (as LAPACK xLACN2): at most 5 steps of power-like iteration with A^{-1} and A^{-T}
+     * and one extra test vector, every step is triangular solves in O(n^2).
+     * Estimate is lower bound of the norm and in practice within factor 3 of it.
+     */
+    abs_type inverse_norm_1_estimate() const
+    {
+        if (is_singular())
+            throw std::invalid_argument{"try to estimate norm of inverse of singular matrix"};
+        if (size() == 0)
+            return abs_type{};
+
+        MATRIX_PROFILE_SCOPE("lu_inverse_norm_1_estimate");
+        constexpr size_type max_iterations = 5;
+        const size_type n = size();
+
+        std::vector<value_type> x (n, value_type{1} / static_cast<value_type>(n));
+        solve_in_place(x);
+        abs_type est = vector_norm_1(x);
+        if (n == 1)
+            return est;
+
+        std::vector<value_type> signs (n);
+        for (size_type i = 0; i < n; i++)
+            signs[i] = sign_of(x[i]);
+        x = signs;
+        solve_transposed_in_place(x);
+        size_type j = argmax_abs(x);
+        size_type solves_num = 2;
+
+        for (size_type iteration = 2; iteration <= max_iterations; iteration++)
+        {
+            std::fill(x.begin(), x.end(), value_type{});
+            x[j] = value_type{1};
+            solve_in_place(x);
+            solves_num++;
+            abs_type old_est = est;
+            est = vector_norm_1(x);
+
+            bool is_same_signs = true;
+            for (size_type i = 0; i < n; i++)
+            {
+                auto sign = sign_of(x[i]);
+                is_same_signs = is_same_signs && cmp_(sign, signs[i]);
+                signs[i] = sign;
+            }
+            // repeated signs mean convergence, not growing estimate means cycling
+            if (is_same_signs || !(old_est < est))
+            {
+                if (est < old_est)
+                    est = old_est;
+                break;
+            }
+            if (iteration == max_iterations)
+                break;
+
+            x = signs;
+            solve_transposed_in_place(x);
+            solves_num++;
+            size_type last_j = j;
+            j = argmax_abs(x);
+            if (!(abs_(x[last_j]) < abs_(x[j])))
+                break;
+        }
+
+        // alternating test vector catches matrices where iteration above is misled
+        for (size_type i = 0; i < n; i++)
+        {
+            x[i] = value_type{1} + static_cast<value_type>(i) / static_cast<value_type>(n - 1);
+            if (i % 2 == 1)
+                x[i] = -x[i];
+        }
+        solve_in_place(x);
+        solves_num++;
+        abs_type alt_est = abs_type{2} * vector_norm_1(x) / static_cast<abs_type>(3 * n);
+        if (est < alt_est)
+            est = alt_est;
+
+        MATRIX_PROFILE_FLOPS(2 * solves_num * n * n);
+        return est;
+    }
+
+    /*
+     * Reciprocal of condition number in 1-norm: 1 / (||A||_1 * ||A^{-1}||_1) with estimated
+     * norm of inverse. mat_norm_1 is norm_1() of factorized matrix (see matrix_reduce.hpp),
+     * take it before factorization. 0 for singular matrix, value near epsilon of T means
+     * solution is not reliable.
+     */
+    abs_type rcond_1(const abs_type& mat_norm_1) const
+    {
+        if (is_singular() || mat_norm_1 == abs_type{})
+            return abs_type{};
+        return abs_type{1} / (mat_norm_1 * inverse_norm_1_estimate());
+    }
+
+    /*
+     * Factorization of A + u * v^T in O(n^2) by Bennett algorithm, u and v are columns.
+     * Update works without pivoting, so if it meets zero pivot factorization is left
+     * as it was and std::invalid_argument is thrown: factorize new matrix from scratch.
+     */
+    void rank_one_update(const matrix_type& u, const matrix_type& v)
+    {
+        if (!u.is_column() || !v.is_column() || u.height() != size() || v.height() != size())
+            throw std::invalid_argument{"in rank_one_update: u and v have to be columns of size of matrix"};
+
+        MATRIX_PROFILE_SCOPE("lu_rank_one_update");
+        matrix_type updated {lu_};
+        std::vector<value_type> x (size()), y (size());
+        for (size_type i = 0; i < size(); i++)
+        {
+            x[i] = u.to(perm_[i], 0);
+            y[i] = v.to(i, 0);
+        }
+
+        for (size_type i = 0; i < size(); i++)
+        {
+            auto& row_i = updated[perm_[i]];
+            row_i[i] += x[i] * y[i];
+            if (cmp_(row_i[i], value_type{}))
+                throw std::invalid_argument{"rank one update of LU factorization meets zero pivot"};
+            y[i] /= row_i[i];
+            for (size_type j = i + 1; j < size(); j++)
+            {
+                auto& row_j = updated[perm_[j]];
+                x[j] -= x[i] * row_j[i];
+                row_j[i] += y[i] * x[j];
+            }
+            for (size_type j = i + 1; j < size(); j++)
+            {
+                row_i[j] += x[i] * y[j];
+                y[j] -= y[i] * row_i[j];
+            }
+        }
+        MATRIX_PROFILE_FLOPS(4 * size() * size());
+        lu_ = std::move(updated);
+    }
+
+    // factorization of A + U * V^T, U and V are n x k, costs O(n^2 * k)
+    void rank_update(const matrix_type& u, const matrix_type& v)
+    {
+        if (u.height() != size() || v.height() != size() || u.width() != v.width())
+            throw std::invalid_argument{"in rank_update: U and V have to be n x k"};
+
+        LUDecomposition updated {*this};
+        for (size_type col = 0; col < u.width(); col++)
+        {
+            matrix_type u_col (size(), 1), v_col (size(), 1);
+            for (size_type i = 0; i < size(); i++)
+            {
+                u_col.to(i, 0) = u.to(i, col);
+                v_col.to(i, 0) = v.to(i, col);
+            }
+            updated.rank_one_update(u_col, v_col);
+        }
+        *this = std::move(updated);
+    }
+
+    matrix_type upper() const
+    {
+        matrix_type res (size(), size());
+        for (size_type i = 0; i < size(); i++)
+            for (size_type j = i; j < size(); j++)
+                res.to(i, j) = packed(i, j);
+        return res;
+    }
+};
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+LUDecomposition<T, IsDivArithm, Cmp, Abs> lu(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return LUDecomposition<T, IsDivArithm, Cmp, Abs>{mat};
+}
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+MatrixArithmetic<T, IsDivArithm, Cmp, Abs> solve(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat,
+                                                 const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs)
+{
+    return lu(mat).solve(rhs);
+}
+
+} // namespace Matrix
@@ -0,0 +1,99 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include "matrix_lu.hpp"
+#include "matrix_reduce.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Mixed precision solve: O(n^3) factorization is done in float, then solution  |
+ * is refined with residuals computed in double, every refinement step costs     |
+ * only O(n^2). If refinement does not converge (matrix is too ill-conditioned  |
+ * for float) system is solved again with double factorization.                 |
+ * It pays off for few right hand sides only: refinement of all n columns of I  |
+ * costs more than inverse by double LU, so there is no mixed inverse.          |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+
+struct RefinementParams
+{
+    std::size_t max_iterations = 30;
+};
+
+template<class Cmp, class Abs>
+struct MixedSolution
+{
+    MatrixArithmetic<double, true, Cmp, Abs> solution;
+    std::size_t iterations;
+    bool is_fallback; // true if float refinement failed and double factorization was used
+};
+
+namespace detail
+{
+
+template<typename To, class ToCmp = std::equal_to<To>, class ToAbs = DefaultAbs<To>,
+         typename From, bool IsDivArithm, class Cmp, class Abs>
+MatrixArithmetic<To, IsDivArithm, ToCmp, ToAbs> convert(const MatrixArithmetic<From, IsDivArithm, Cmp, Abs>& mat)
+{
+    MatrixArithmetic<To, IsDivArithm, ToCmp, ToAbs> res (mat.height(), mat.width());
+    for (std::size_t i = 0; i < mat.height(); i++)
+        for (std::size_t j = 0; j < mat.width(); j++)
+            res.to(i, j) = static_cast<To>(mat.to(i, j));
+    return res;
+}
+
+} // namespace detail
+
+template<class Cmp, class Abs>
+MixedSolution<Cmp, Abs> mixed_solve(const MatrixArithmetic<double, true, Cmp, Abs>& mat,
+                                    const MatrixArithmetic<double, true, Cmp, Abs>& rhs,
+                                    const RefinementParams& params = {})
+{
+    using matrix_type = MatrixArithmetic<double, true, Cmp, Abs>;
+
+    if (!mat.is_square())
+        throw std::invalid_argument{"try to solve system with no square matrix"};
+    if (rhs.height() != mat.height())
+        throw std::invalid_argument{"in mixed_solve: rhs.height() != mat.height()"};
+
+    MATRIX_PROFILE_SCOPE("mixed_solve");
+    auto fallback = [&](std::size_t iterations)
+    {
+        return MixedSolution<Cmp, Abs>{lu(mat).solve(rhs), iterations, true};
+    };
+
+    auto mat_lu = lu(detail::convert<float>(mat));
+    if (mat_lu.is_singular())
+        return fallback(0);
+
+    auto solution = detail::convert<double, Cmp, Abs>(mat_lu.solve(detail::convert<float>(rhs)));
+
+    // stop criteria like in LAPACK dsgesv: ||r|| <= ||x|| * ||A|| * eps * sqrt(n)
+    const double threshold = norm_inf(mat) * std::numeric_limits<double>::epsilon() *
+                             std::sqrt(static_cast<double>(mat.height()));
+
+    // iteration is number of corrections done, also when refinement breaks on not finite residual
+    std::size_t iteration = 0;
+    for (;; iteration++)
+    {
+        matrix_type residual = rhs - product(mat, solution);
+        double residual_norm = norm_inf(residual);
+        if (!std::isfinite(residual_norm))
+            break;
+        if (residual_norm <= norm_inf(solution) * threshold)
+            return {solution, iteration, false};
+
+        if (iteration == params.max_iterations)
+            break;
+        auto correction = mat_lu.solve(detail::convert<float>(residual));
+        for (std::size_t i = 0; i < solution.height(); i++)
+            for (std::size_t j = 0; j < solution.width(); j++)
+                solution.to(i, j) += static_cast<double>(correction.to(i, j));
+    }
+    return fallback(iteration);
+}
+
+} // namespace Matrix
@@ -0,0 +1,349 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace Matrix
+{
+namespace detail
+{
+
+// asked once: hardware_concurrency() queries the OS on every call
+inline std::size_t hardware_threads()
+{
+    static const std::size_t n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    return n_threads;
+}
+
+// cpus allowed for process (taken from main thread), empty if affinity is not supported
+inline const std::vector<int>& allowed_cpus()
+{
+    static const std::vector<int> cpus = []
+    {
+        std::vector<int> res;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(getpid(), sizeof(set), &set) == 0)
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                if (CPU_ISSET(cpu, &set))
+                    res.push_back(cpu);
+#endif
+        return res;
+    }();
+    return cpus;
+}
+
+// binds current thread to ind-th allowed cpu (round robin), returns false if it is not supported
+inline bool pin_current_thread(std::size_t ind)
+{
+#if defined(__linux__)
+    const auto& cpus = allowed_cpus();
+    if (cpus.empty())
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[ind % cpus.size()], &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+// chunk of rows for elementwise operations: too small chunks do not pay for thread start
+inline std::size_t rows_per_chunk(std::size_t width)
+{
+    constexpr std::size_t elems_per_chunk = 1 << 15;
+    return std::max<std::size_t>(1, elems_per_chunk / std::max<std::size_t>(width, 1));
+}
+
+// threads started by parallel_for which are running now: all regions together, nested and concurrent,
+// never start more than hardware_threads() - 1 of them, so nested regions do not oversubscribe cores
+inline std::atomic<std::size_t>& busy_threads()
+{
+    static std::atomic<std::size_t> busy {0};
+    return busy;
+}
+
+// takes up to wanted threads from what is left of budget, returns how many are taken
+inline std::size_t acquire_threads(std::size_t wanted)
+{
+    auto& busy = busy_threads();
+    const std::size_t limit = hardware_threads() - 1;
+    std::size_t cur = busy.load();
+    for (;;)
+    {
+        std::size_t taken = std::min(wanted, limit - std::min(limit, cur));
+        if (taken == 0 || busy.compare_exchange_weak(cur, cur + taken))
+            return taken;
+    }
+}
+
+// depth of parallel_for regions current thread runs in
+inline thread_local std::size_t parallel_depth = 0;
+
+struct DepthGuard
+{
+    DepthGuard()  {parallel_depth++;}
+    ~DepthGuard() {parallel_depth--;}
+};
+
+// threads of one region: joins started threads and gives reserved ones back to budget, also on unwind
+struct ThreadRegion
+{
+    std::size_t n_reserved;
+    std::vector<std::thread> threads {};
+
+    explicit ThreadRegion(std::size_t reserved): n_reserved {reserved} {}
+    ThreadRegion(const ThreadRegion&) = delete;
+    ThreadRegion& operator=(const ThreadRegion&) = delete;
+
+    ~ThreadRegion()
+    {
+        for (auto& thread: threads)
+            if (thread.joinable())
+                thread.join();
+        busy_threads() -= n_reserved;
+    }
+
+    void join()
+    {
+        for (auto& thread: threads)
+            thread.join();
+    }
+};
+
+// split [begin, end) into contiguous chunks not smaller than min_chunk and call func(first, last) for each
+// chunk in its own thread, current thread takes the first chunk; exception from any chunk is rethrown.
+// Number of chunks is limited by threads which are free now, so func must not depend on partition.
+// With is_pinned thread of k-th chunk is bound to k-th allowed cpu, but only in outermost region:
+// threads of nested regions are never pinned.
+// If thread can't be started, its chunks are done by current thread.
+template<typename Func>
+void parallel_for(std::size_t begin, std::size_t end, Func func, std::size_t min_chunk = 1, bool is_pinned = false)
+{
+    if (begin >= end)
+        return;
+
+    std::size_t len = end - begin;
+    if (len <= min_chunk)
+    {
+        DepthGuard guard;
+        func(begin, end);
+        return;
+    }
+
+    std::size_t max_chunks = std::min(hardware_threads(), (len + min_chunk - 1) / std::max<std::size_t>(min_chunk, 1));
+    std::size_t n_extra = (max_chunks > 1) ? acquire_threads(max_chunks - 1) : 0;
+    std::size_t n_chunks = n_extra + 1;
+
+    if (n_chunks == 1)
+    {
+        DepthGuard guard;
+        func(begin, end);
+        return;
+    }
+
+    ThreadRegion region {n_extra};
+
+    const bool is_pinning = is_pinned && parallel_depth == 0;
+    std::vector<std::exception_ptr> errors (n_chunks);
+    auto chunk_begin = [&](std::size_t chunk) {return begin + len * chunk / n_chunks;};
+    auto run_chunk = [&](std::size_t chunk)
+    {
+        DepthGuard guard;
+        try {func(chunk_begin(chunk), chunk_begin(chunk + 1));}
+        catch (...) {errors[chunk] = std::current_exception();}
+    };
+
+    std::size_t n_started = 1;
+    try
+    {
+        region.threads.reserve(n_extra);
+        for (; n_started < n_chunks; n_started++)
+            region.threads.emplace_back([&, chunk = n_started]
+            {
+                if (is_pinning)
+                    pin_current_thread(chunk);
+                run_chunk(chunk);
+            });
+    }
+    catch (...) {}
+
+    run_chunk(0);
+    for (std::size_t chunk = n_started; chunk < n_chunks; chunk++)
+        run_chunk(chunk);
+
+    region.join();
+    for (auto& error: errors)
+        if (error)
+            std::rethrow_exception(error);
+}
+
+// number of cpus threads of placed_parallel_for are pinned to
+inline std::size_t placement_cpus()
+{
+    return allowed_cpus().empty() ? hardware_threads() : allowed_cpus().size();
+}
+
+// parts of [0, len) for placed_parallel_for: one part if len < min_len, otherwise one per cpu (at most len),
+// so partition depends only on length and number of cpus
+inline std::size_t placement_parts(std::size_t len, std::size_t min_len)
+{
+    return (len < min_len) ? 1 : std::min(len, placement_cpus());
+}
+
+/*
+ * parallel_for with fixed partition for first touch placement: [begin, end) is cut in placement_parts()
+ * equal parts and part k always runs on thread pinned to k-th allowed cpu, while calling thread waits.
+ * So pages written first by part k are on NUMA node of that cpu and later calls over rows of the same
+ * height find them there. Threads are pinned only in outermost region when budget has thread for every
+ * part, otherwise parts go by parallel_for unpinned and placement is not kept.
+ */
+template<typename Func>
+void placed_parallel_for(std::size_t begin, std::size_t end, Func func, std::size_t min_len = 2)
+{
+    if (begin >= end)
+        return;
+
+    const std::size_t len = end - begin, n_parts = placement_parts(len, min_len);
+    auto part_begin = [&](std::size_t part) {return begin + len * part / n_parts;};
+    if (n_parts == 1)
+    {
+        DepthGuard guard;
+        func(begin, end);
+        return;
+    }
+
+    std::size_t n_taken = (parallel_depth == 0) ? acquire_threads(n_parts - 1) : 0;
+    if (n_taken + 1 < n_parts)
+    {
+        busy_threads() -= n_taken;
+        parallel_for(0, n_parts, [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t part = first; part < last; part++)
+                func(part_begin(part), part_begin(part + 1));
+        });
+        return;
+    }
+
+    ThreadRegion region {n_taken};
+    std::vector<std::exception_ptr> errors (n_parts);
+    auto run_part = [&](std::size_t part)
+    {
+        DepthGuard guard;
+        try {func(part_begin(part), part_begin(part + 1));}
+        catch (...) {errors[part] = std::current_exception();}
+    };
+
+    // if thread can't be started, its parts are done by calling thread
+    std::size_t n_started = 0;
+    try
+    {
+        region.threads.reserve(n_parts);
+        for (; n_started < n_parts; n_started++)
+            region.threads.emplace_back([&, part = n_started]
+            {
+                pin_current_thread(part);
+                run_part(part);
+            });
+    }
+    catch (...) {}
+
+    for (std::size_t part = n_started; part < n_parts; part++)
+        run_part(part);
+    region.join();
+    for (auto& error: errors)
+        if (error)
+            std::rethrow_exception(error);
+}
+
+} // namespace detail
+
+// simple FIFO pool, tasks must not wait for other tasks of the same pool,
+// pinned pool binds i-th worker to i-th allowed cpu
+class ThreadPool
+{
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool is_stopped_ = false;
+
+    void work()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock lock {mutex_};
+                cond_.wait(lock, [this]{return is_stopped_ || !tasks_.empty();});
+                if (tasks_.empty())
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit ThreadPool(std::size_t n_threads = detail::hardware_threads(), bool is_pinned = false)
+    {
+        workers_.reserve(n_threads);
+        for (std::size_t i = 0; i < std::max<std::size_t>(n_threads, 1); i++)
+            workers_.emplace_back([this, i, is_pinned]
+            {
+                if (is_pinned)
+                    detail::pin_current_thread(i);
+                work();
+            });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // finishes all submitted tasks before destruction
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock {mutex_};
+            is_stopped_ = true;
+        }
+        cond_.notify_all();
+        for (auto& worker: workers_)
+            worker.join();
+    }
+
+    std::size_t size() const {return workers_.size();}
+
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock {mutex_};
+            tasks_.push_back(std::move(task));
+        }
+        cond_.notify_one();
+    }
+
+    static ThreadPool& shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+};
+
+} // namespace Matrix
@@ -0,0 +1,245 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Operation profiler.                                                          |
+ * Probes are compiled in only if MATRIX_PROFILE is defined (cmake option       |
+ * -DMATRIX_PROFILE=ON), otherwise all MATRIX_PROFILE_* macros expand to        |
+ * nothing and library code does not touch profiler at all.                     |
+ * Query and dump functions are always available: without probes they just     |
+ * return empty statistics.                                                     |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+namespace profiler
+{
+
+struct OpStats
+{
+    std::size_t   calls           = 0;
+    std::uint64_t wall_ns         = 0;
+    std::uint64_t flops           = 0;
+    std::uint64_t bytes_allocated = 0;
+    std::size_t   temporaries     = 0;
+
+    OpStats& operator+=(const OpStats& rhs)
+    {
+        calls           += rhs.calls;
+        wall_ns         += rhs.wall_ns;
+        flops           += rhs.flops;
+        bytes_allocated += rhs.bytes_allocated;
+        temporaries     += rhs.temporaries;
+        return *this;
+    }
+};
+
+struct TraceEvent
+{
+    const char*   name;
+    std::uint64_t start_ns;
+    std::uint64_t duration_ns;
+    std::size_t   thread_id;
+    std::uint64_t flops;
+};
+
+class Profiler
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+private:
+    mutable std::mutex mutex_ {};
+    std::map<std::string, OpStats> stats_ {};
+    std::vector<TraceEvent> trace_ {};
+    bool trace_enabled_ = true;
+    clock::time_point origin_ = clock::now();
+
+    Profiler() = default;
+
+public:
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    static Profiler& instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    std::uint64_t now_ns() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - origin_).count();
+    }
+
+    void record(const char* name, std::uint64_t start_ns, const OpStats& op)
+    {
+        std::lock_guard lock {mutex_};
+        stats_[name] += op;
+        if (trace_enabled_)
+            trace_.push_back({name, start_ns, op.wall_ns,
+                              std::hash<std::thread::id>{}(std::this_thread::get_id()), op.flops});
+    }
+
+//--------------------------------=| Query API start |=-------------------------------------------------
+    OpStats stats(const std::string& name) const
+    {
+        std::lock_guard lock {mutex_};
+        auto itr = stats_.find(name);
+        return (itr == stats_.end()) ? OpStats{} : itr->second;
+    }
+
+    std::map<std::string, OpStats> snapshot() const
+    {
+        std::lock_guard lock {mutex_};
+        return stats_;
+    }
+
+    std::vector<TraceEvent> trace() const
+    {
+        std::lock_guard lock {mutex_};
+        return trace_;
+    }
+
+    void enable_trace(bool enable)
+    {
+        std::lock_guard lock {mutex_};
+        trace_enabled_ = enable;
+    }
+
+    void reset()
+    {
+        std::lock_guard lock {mutex_};
+        stats_.clear();
+        trace_.clear();
+        origin_ = clock::now();
+    }
+//--------------------------------=| Query API end |=---------------------------------------------------
+
+//--------------------------------=| Dumps start |=-----------------------------------------------------
+    std::ostream& dump_summary(std::ostream& os) const
+    {
+        auto stats_cpy = snapshot();
+        os << "operation calls wall_ms flops bytes_allocated temporaries\n";
+        for (const auto& [name, op]: stats_cpy)
+            os << name << ' ' << op.calls << ' ' << static_cast<double>(op.wall_ns) / 1e6 << ' '
+               << op.flops << ' ' << op.bytes_allocated << ' ' << op.temporaries << '\n';
+        return os;
+    }
+
+    // Chrome trace-event format, open it in chrome://tracing or Perfetto
+    std::ostream& dump_chrome_trace(std::ostream& os) const
+    {
+        auto trace_cpy = trace();
+        os << "{\"traceEvents\":[";
+        for (std::size_t i = 0; i < trace_cpy.size(); i++)
+        {
+            const auto& event = trace_cpy[i];
+            if (i != 0)
+                os << ',';
+            os << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0"
+               << ",\"tid\":" << event.thread_id
+               << ",\"ts\":" << static_cast<double>(event.start_ns) / 1e3
+               << ",\"dur\":" << static_cast<double>(event.duration_ns) / 1e3
+               << ",\"args\":{\"flops\":" << event.flops << "}}";
+        }
+        os << "]}";
+        return os;
+    }
+//--------------------------------=| Dumps end |=-------------------------------------------------------
+};
+
+namespace detail
+{
+class ScopedProbe;
+inline thread_local ScopedProbe* current_probe = nullptr;
+
+// measures one call of operation, nested probes are independent
+class ScopedProbe
+{
+    const char* name_;
+    std::uint64_t start_ns_;
+    OpStats op_ {};
+    ScopedProbe* parent_;
+
+public:
+    explicit ScopedProbe(const char* name)
+    :name_ {name}, start_ns_ {Profiler::instance().now_ns()}, parent_ {current_probe}
+    {
+        op_.calls = 1;
+        current_probe = this;
+    }
+
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+
+    ~ScopedProbe()
+    {
+        current_probe = parent_;
+        op_.wall_ns = Profiler::instance().now_ns() - start_ns_;
+        Profiler::instance().record(name_, start_ns_, op_);
+    }
+
+    void add_flops(std::uint64_t flops) {op_.flops += flops;}
+    void add_alloc(std::uint64_t bytes) {op_.bytes_allocated += bytes;}
+    void add_temporary(std::uint64_t bytes)
+    {
+        op_.temporaries++;
+        op_.bytes_allocated += bytes;
+    }
+};
+
+// allocations are charged to innermost operation on this thread
+inline void count_alloc(std::uint64_t bytes)
+{
+    if (current_probe)
+        current_probe->add_alloc(bytes);
+}
+
+inline void count_temporary(std::uint64_t bytes)
+{
+    if (current_probe)
+        current_probe->add_temporary(bytes);
+}
+
+inline void count_flops(std::uint64_t flops)
+{
+    if (current_probe)
+        current_probe->add_flops(flops);
+}
+} // namespace detail
+
+inline OpStats stats(const std::string& name) {return Profiler::instance().stats(name);}
+inline std::map<std::string, OpStats> snapshot() {return Profiler::instance().snapshot();}
+inline void reset() {Profiler::instance().reset();}
+inline std::ostream& dump_summary(std::ostream& os) {return Profiler::instance().dump_summary(os);}
+inline std::ostream& dump_chrome_trace(std::ostream& os) {return Profiler::instance().dump_chrome_trace(os);}
+
+} // namespace profiler
+} // namespace Matrix
+
+#ifdef MATRIX_PROFILE
+#define MATRIX_PROFILE_CONCAT_IMPL(a, b) a##b
+#define MATRIX_PROFILE_CONCAT(a, b) MATRIX_PROFILE_CONCAT_IMPL(a, b)
+#define MATRIX_PROFILE_SCOPE(name) \
+    ::Matrix::profiler::detail::ScopedProbe MATRIX_PROFILE_CONCAT(matrix_probe_, __LINE__) {name}
+#define MATRIX_PROFILE_FLOPS(flops) ::Matrix::profiler::detail::count_flops(static_cast<std::uint64_t>(flops))
+#define MATRIX_PROFILE_ALLOC(bytes) ::Matrix::profiler::detail::count_alloc(static_cast<std::uint64_t>(bytes))
+#define MATRIX_PROFILE_TEMPORARY(bytes) ::Matrix::profiler::detail::count_temporary(static_cast<std::uint64_t>(bytes))
+#else
+#define MATRIX_PROFILE_SCOPE(name)      ((void)0)
+#define MATRIX_PROFILE_FLOPS(flops)     ((void)0)
+#define MATRIX_PROFILE_ALLOC(bytes)     ((void)0)
+#define MATRIX_PROFILE_TEMPORARY(bytes) ((void)0)
+#endif
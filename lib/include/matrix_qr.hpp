@@ -0,0 +1,371 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "matrix_arithmetic.hpp"
+#include "matrix_parallel.hpp"
+#include "matrix_storage.hpp"
+#include "matrix_strassen.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Householder QR: A = Q * R, A is m x n, m >= n.                                |
+ * Columns are factorized by panels of block_size, every panel is applied to    |
+ * trailing columns at once in compact WY form Q^T = I - V * T^T * V^T:         |
+ * W = V^T * C and C -= V * (T^T * W) are two matrix products done by product  |
+ * kernel on chunks of trailing columns in parallel.                            |
+ * least_squares() splits very tall matrices by row blocks (TSQR): blocks are   |
+ * factorized in parallel and their R factors are reduced by one more QR.       |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+namespace detail
+{
+
+// m x n matrix stored by columns: every column is contiguous
+template<typename T>
+class ColumnBuffer
+{
+    std::size_t height_, width_, stride_;
+    aligned_vector<T> data_;
+
+public:
+    ColumnBuffer(std::size_t m, std::size_t n)
+    :height_ {m}, width_ {n}, stride_ {padded_stride<T>(m)}, data_ (stride_ * n)
+    {}
+
+    std::size_t height() const {return height_;}
+    std::size_t width()  const {return width_;}
+    std::size_t stride() const {return stride_;}
+
+    T*       col(std::size_t j)       {return data_.data() + j * stride_;}
+    const T* col(std::size_t j) const {return data_.data() + j * stride_;}
+
+    T&       operator()(std::size_t i, std::size_t j)       {return data_[j * stride_ + i];}
+    const T& operator()(std::size_t i, std::size_t j) const {return data_[j * stride_ + i];}
+};
+
+// reflector I - tau * v * v^T, v = (1, x / (alpha - beta)), which maps (alpha, x) to (beta, 0): alpha is
+// replaced by beta and len elements of x with step inc by tail of v, returns tau (0 if x is already zero)
+template<typename T>
+T make_householder(T& alpha, T* x, std::size_t len, std::size_t inc)
+{
+    T sigma {};
+    for (std::size_t i = 0; i < len; i++)
+        sigma += x[i * inc] * x[i * inc];
+    if (sigma == T{})
+        return T{};
+    T beta = -std::copysign(std::sqrt(alpha * alpha + sigma), alpha);
+    T tau = (beta - alpha) / beta;
+    T scale = T{1} / (alpha - beta);
+    for (std::size_t i = 0; i < len; i++)
+        x[i * inc] *= scale;
+    alpha = beta;
+    return tau;
+}
+
+// upper triangular T of block of jb reflectors: H_0 * ... * H_(jb-1) = I - V * T * V^T,
+// tau are their coefficients and dot(i, k) = v_i^T * v_k for k < i
+template<typename T, typename Dot>
+std::vector<T> block_reflector_factor(const T* tau, std::size_t jb, Dot dot)
+{
+    std::vector<T> t (jb * jb), w (jb);
+    for (std::size_t i = 0; i < jb; i++)
+    {
+        t[i * jb + i] = tau[i];
+        // t(0:i, i) = -tau_i * T(0:i, 0:i) * V(:, 0:i)^T * v_i
+        for (std::size_t k = 0; k < i; k++)
+            w[k] = dot(i, k);
+        for (std::size_t r = 0; r < i; r++)
+        {
+            T sum {};
+            for (std::size_t k = r; k < i; k++)
+                sum += t[r * jb + k] * w[k];
+            t[r * jb + i] = -tau[i] * sum;
+        }
+    }
+    return t;
+}
+
+template<typename T>
+class HouseholderQR
+{
+    ColumnBuffer<T> qr_;
+    std::vector<T> tau_;
+    std::size_t block_size_;
+
+    // reflector for column j from row j: x -> beta * e_1, v(j) = 1 is implicit
+    void make_reflector(std::size_t j)
+    {
+        T* x = qr_.col(j);
+        tau_[j] = make_householder(x[j], x + j + 1, qr_.height() - j - 1, 1);
+    }
+
+    // dot of reflector j with x from row j
+    T dot_reflector(std::size_t j, const T* x) const
+    {
+        const T* v = qr_.col(j);
+        T res = x[j];
+        for (std::size_t i = j + 1; i < qr_.height(); i++)
+            res += v[i] * x[i];
+        return res;
+    }
+
+    void axpy_reflector(std::size_t j, T coef, T* x) const
+    {
+        const T* v = qr_.col(j);
+        x[j] -= coef;
+        for (std::size_t i = j + 1; i < qr_.height(); i++)
+            x[i] -= coef * v[i];
+    }
+
+    // x = H_j * x
+    void apply_reflector(std::size_t j, T* x) const
+    {
+        if (tau_[j] != T{})
+            axpy_reflector(j, tau_[j] * dot_reflector(j, x), x);
+    }
+
+    // upper triangular T of block [j0, j0 + jb): H_j0 * ... * H_(j0+jb-1) = I - V * T * V^T
+    std::vector<T> block_factor(std::size_t j0, std::size_t jb) const
+    {
+        return block_reflector_factor(tau_.data() + j0, jb, [&](std::size_t i, std::size_t k)
+        {
+            return dot_reflector(j0 + i, qr_.col(j0 + k));
+        });
+    }
+
+    // C = (I - V * T^T * V^T) * C for columns [first, last) of C from row j0, block transformation transposed.
+    // Column-major C is row-major C^T, so update is C^T -= (C^T * V) * (T * V^T), vr is V and tvt is T * V^T
+    void apply_block_transposed(std::size_t j0, std::size_t jb, aligned_vector<T>& vr, aligned_vector<T>& tvt,
+                                std::size_t first, std::size_t last)
+    {
+        const std::size_t mr = qr_.height() - j0, nc = last - first;
+        aligned_vector<T> wt (nc * jb), d (nc * mr);
+        StrassenWinograd<T> gemm {0};
+        BlockView<T> ct {qr_.col(first) + j0, qr_.stride()};
+        gemm(ct, {vr.data(), jb}, {wt.data(), jb}, nc, mr, jb, 0);
+        gemm({wt.data(), jb}, {tvt.data(), mr}, {d.data(), mr}, nc, jb, mr, 0);
+        for (std::size_t c = 0; c < nc; c++)
+        {
+            T* col = qr_.col(first + c) + j0;
+            const T* d_row = d.data() + c * mr;
+            for (std::size_t i = 0; i < mr; i++)
+                col[i] -= d_row[i];
+        }
+    }
+
+public:
+    HouseholderQR(ColumnBuffer<T> mat, std::size_t block_size = 32)
+    :qr_ {std::move(mat)}, tau_ (std::min(qr_.height(), qr_.width())), block_size_ {std::max<std::size_t>(block_size, 1)}
+    {
+        const std::size_t n = qr_.width(), r = tau_.size();
+        for (std::size_t j0 = 0; j0 < r; j0 += block_size_)
+        {
+            std::size_t jb = std::min(block_size_, r - j0);
+            for (std::size_t j = j0; j < j0 + jb; j++)
+            {
+                make_reflector(j);
+                for (std::size_t c = j + 1; c < j0 + jb; c++)
+                    apply_reflector(j, qr_.col(c));
+            }
+            if (j0 + jb >= n)
+                continue;
+
+            // explicit V (unit diagonal, zeros above) as row-major mr x jb and T * V^T as row-major jb x mr
+            const std::size_t mr = qr_.height() - j0;
+            aligned_vector<T> vr (mr * jb), vt (jb * mr), tvt (jb * mr);
+            for (std::size_t k = 0; k < jb; k++)
+            {
+                vr[k * jb + k] = vt[k * mr + k] = T{1};
+                for (std::size_t i = k + 1; i < mr; i++)
+                    vr[i * jb + k] = vt[k * mr + i] = qr_(j0 + i, j0 + k);
+            }
+            auto t = block_factor(j0, jb);
+            StrassenWinograd<T> {0}({t.data(), jb}, {vt.data(), mr}, {tvt.data(), mr}, jb, jb, mr, 0);
+
+            parallel_for(j0 + jb, n, [&](std::size_t first, std::size_t last)
+            {
+                apply_block_transposed(j0, jb, vr, tvt, first, last);
+            }, 8);
+        }
+    }
+
+    std::size_t height() const {return qr_.height();}
+    std::size_t width()  const {return qr_.width();}
+
+    const T& r(std::size_t i, std::size_t j) const {return qr_(i, j);}
+
+    // x = Q^T * x, x has height() elements
+    void apply_qt(T* x) const
+    {
+        for (std::size_t j = 0; j < tau_.size(); j++)
+            apply_reflector(j, x);
+    }
+
+    // x = Q * x
+    void apply_q(T* x) const
+    {
+        for (std::size_t j = tau_.size() - 1; static_cast<long long>(j) >= 0; j--)
+            apply_reflector(j, x);
+    }
+
+    // solve R * x = y in place for first width() elements, false if R is singular
+    bool solve_r(T* y) const
+    {
+        for (std::size_t i = width() - 1; static_cast<long long>(i) >= 0; i--)
+        {
+            T sum = y[i];
+            for (std::size_t j = i + 1; j < width(); j++)
+                sum -= qr_(i, j) * y[j];
+            if (qr_(i, i) == T{})
+                return false;
+            y[i] = sum / qr_(i, i);
+        }
+        return true;
+    }
+};
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+ColumnBuffer<T> to_columns(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat, std::size_t first_row, std::size_t last_row)
+{
+    ColumnBuffer<T> res (last_row - first_row, mat.width());
+    for (std::size_t i = first_row; i < last_row; i++)
+        for (std::size_t j = 0; j < mat.width(); j++)
+            res(i - first_row, j) = mat.to(i, j);
+    return res;
+}
+
+} // namespace detail
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+class QRDecomposition
+{
+public:
+    using matrix_type = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+    using size_type   = typename matrix_type::size_type;
+
+private:
+    detail::HouseholderQR<T> qr_;
+
+    // shape is checked before factorization starts
+    static const matrix_type& checked(const matrix_type& mat)
+    {
+        if (mat.height() < mat.width())
+            throw std::invalid_argument{"QR factorization needs height() >= width()"};
+        return mat;
+    }
+
+public:
+    explicit QRDecomposition(const matrix_type& mat, size_type block_size = 32)
+    :qr_ {detail::to_columns(checked(mat), 0, mat.height()), block_size}
+    {}
+
+    // n x n upper triangular
+    matrix_type r() const
+    {
+        matrix_type res (qr_.width(), qr_.width());
+        for (size_type i = 0; i < qr_.width(); i++)
+            for (size_type j = i; j < qr_.width(); j++)
+                res.to(i, j) = qr_.r(i, j);
+        return res;
+    }
+
+    // thin m x n Q with orthonormal columns
+    matrix_type q() const
+    {
+        matrix_type res (qr_.height(), qr_.width());
+        std::vector<T> col (qr_.height());
+        for (size_type j = 0; j < qr_.width(); j++)
+        {
+            std::fill(col.begin(), col.end(), T{});
+            col[j] = T{1};
+            qr_.apply_q(col.data());
+            for (size_type i = 0; i < qr_.height(); i++)
+                res.to(i, j) = col[i];
+        }
+        return res;
+    }
+
+    // x minimizing ||A * x - b|| for every column of b
+    matrix_type solve(const matrix_type& rhs) const
+    {
+        if (rhs.height() != qr_.height())
+            throw std::invalid_argument{"in least squares solve: rhs.height() != height of factorized matrix"};
+
+        matrix_type res (qr_.width(), rhs.width());
+        std::vector<T> col (qr_.height());
+        for (size_type c = 0; c < rhs.width(); c++)
+        {
+            for (size_type i = 0; i < qr_.height(); i++)
+                col[i] = rhs.to(i, c);
+            qr_.apply_qt(col.data());
+            if (!qr_.solve_r(col.data()))
+                throw std::invalid_argument{"least squares problem with rank deficient matrix"};
+            for (size_type i = 0; i < qr_.width(); i++)
+                res.to(i, c) = col[i];
+        }
+        return res;
+    }
+};
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+QRDecomposition<T, IsDivArithm, Cmp, Abs> qr(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return QRDecomposition<T, IsDivArithm, Cmp, Abs>{mat};
+}
+
+// n_blocks - number of row blocks for TSQR, 0 - choose by number of threads
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+MatrixArithmetic<T, IsDivArithm, Cmp, Abs> least_squares(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat,
+                                                         const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs,
+                                                         std::size_t n_blocks = 0)
+{
+    using matrix_type = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+
+    const std::size_t m = mat.height(), n = mat.width(), k = rhs.width();
+    if (m < n)
+        throw std::invalid_argument{"least squares needs height() >= width()"};
+    if (rhs.height() != m)
+        throw std::invalid_argument{"in least_squares: rhs.height() != mat.height()"};
+
+    MATRIX_PROFILE_SCOPE("least_squares");
+    // every block has to be at least as tall as wide, small blocks are not worth threads
+    std::size_t max_blocks = m / std::max<std::size_t>(n, 1024);
+    if (n_blocks == 0)
+        n_blocks = std::min(detail::hardware_threads(), max_blocks);
+    n_blocks = std::max<std::size_t>(1, std::min(n_blocks, m / std::max<std::size_t>(n, 1)));
+
+    if (n_blocks == 1)
+        return QRDecomposition<T, IsDivArithm, Cmp, Abs>{mat}.solve(rhs);
+
+    // R_i and first n rows of Q_i^T * b_i of every block are stacked one under another
+    matrix_type stacked_r (n_blocks * n, n), stacked_c (n_blocks * n, k);
+    detail::parallel_for(0, n_blocks, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t blk = first; blk < last; blk++)
+        {
+            std::size_t row_begin = m * blk / n_blocks, row_end = m * (blk + 1) / n_blocks;
+            detail::HouseholderQR<T> block_qr {detail::to_columns(mat, row_begin, row_end)};
+            for (std::size_t i = 0; i < n; i++)
+                for (std::size_t j = i; j < n; j++)
+                    stacked_r.to(blk * n + i, j) = block_qr.r(i, j);
+
+            std::vector<T> col (row_end - row_begin);
+            for (std::size_t c = 0; c < k; c++)
+            {
+                for (std::size_t i = row_begin; i < row_end; i++)
+                    col[i - row_begin] = rhs.to(i, c);
+                block_qr.apply_qt(col.data());
+                for (std::size_t i = 0; i < n; i++)
+                    stacked_c.to(blk * n + i, c) = col[i];
+            }
+        }
+    });
+
+    return QRDecomposition<T, IsDivArithm, Cmp, Abs>{stacked_r}.solve(stacked_c);
+}
+
+} // namespace Matrix
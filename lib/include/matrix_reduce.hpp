@@ -0,0 +1,410 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <concepts>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "matrix_accurate.hpp"
+#include "matrix_arithmetic.hpp"
+#include "matrix_parallel.hpp"
+#include "matrix_vector.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Reductions over all elements: sums, trace, norms, min and max with position. |
+ * reduce() computes any set of them in one pass over memory: blocks of rows go |
+ * in parallel, every row is loaded once and all requested values are           |
+ * accumulated from it while it is in cache, then partials of blocks are        |
+ * combined in order of rows. Size of block depends only on width, so floating  |
+ * point results are the same for any number of threads.                        |
+ * Free functions (sum(), norm_1(), ...) are reduce() with one requested value. |
+ * Floating point sum, trace and sum of squares can be accumulated with pairwise|
+ * or compensated summation: every row gives its part with rounding error, and  |
+ * parts of all rows are summed by the same summation in order of rows.         |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+
+// what reduce() has to compute
+struct ReductionSet
+{
+    bool sum       = false;
+    bool trace     = false;
+    bool frobenius = false; // sum of squares of absolute values
+    bool norm_1    = false; // max of sums of absolute values in columns
+    bool norm_inf  = false; // max of sums of absolute values in rows
+    bool norm_max  = false; // max of absolute values
+    bool min       = false;
+    bool max       = false;
+    bool row_sums  = false;
+    bool col_sums  = false;
+    Summation summation = Summation::naive; // of sum, trace and frobenius, ignored if elements are not floating point
+};
+
+template<typename T>
+struct ElementPosition
+{
+    T value {};
+    std::size_t row = 0, col = 0;
+};
+
+// fields that were not requested are left default
+template<typename T, typename AbsT>
+struct Reductions
+{
+    T sum {};
+    T trace {};
+    AbsT sum_of_squares {};
+    AbsT norm_1 {};
+    AbsT norm_inf {};
+    AbsT norm_max {};
+    ElementPosition<T> min {}, max {};
+    DenseVector<T> row_sums {}, col_sums {};
+};
+
+namespace detail
+{
+
+template<typename T>
+concept is_less_comparable = requires(const T& arg) {{arg < arg} -> std::convertible_to<bool>;};
+
+// sum of func(row[j]) for j in [0, len), floating point sum goes by independent lanes to be vectorized
+template<typename Acc, typename RowIt, typename Func>
+Acc lanes_sum(RowIt row, std::size_t len, Func func)
+{
+    if constexpr (std::is_floating_point_v<Acc>)
+    {
+        constexpr std::size_t lanes_num = 8;
+        Acc lanes[lanes_num] {};
+        std::size_t j = 0;
+        for (; j + lanes_num <= len; j += lanes_num)
+            for (std::size_t l = 0; l < lanes_num; l++)
+                lanes[l] += func(row[j + l]);
+        for (; j < len; j++)
+            lanes[0] += func(row[j]);
+        Acc res {};
+        for (auto lane: lanes)
+            res += lane;
+        return res;
+    }
+    else
+    {
+        Acc res {};
+        for (std::size_t j = 0; j < len; j++)
+            res += func(row[j]);
+        return res;
+    }
+}
+
+template<typename T, typename AbsT>
+constexpr bool has_accurate_summation = std::floating_point<T> && std::same_as<T, AbsT>;
+
+// sum of x[j] * y[j] (y == nullptr means y[j] = 1), res and err of it are kept in terms
+template<typename T>
+T accurate_part(const T* x, const T* y, std::size_t len, Summation mode, T* terms)
+{
+    if constexpr (std::floating_point<T>)
+    {
+        dot(x, 1, y, 1, len, mode, terms[0], terms[1]);
+        return terms[0] + terms[1];
+    }
+    else
+        return T{};
+}
+
+template<typename T>
+T accurate_total(const std::vector<T>& terms, Summation mode)
+{
+    if constexpr (std::floating_point<T>)
+        return dot<T>(terms.data(), 1, nullptr, 0, terms.size(), mode);
+    else
+        return T{};
+}
+
+// NaN candidate is taken and stays, so norms of matrices with NaN are NaN
+template<typename T>
+void update_max(T& res, const T& candidate)
+{
+    if (res < candidate || !(candidate == candidate))
+        res = candidate;
+}
+
+} // namespace detail
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+Reductions<T, detail::abs_type<T, Abs>> reduce(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat, const ReductionSet& what)
+{
+    using size_type = std::size_t;
+    using abs_t = detail::abs_type<T, Abs>;
+
+    if (what.trace && !mat.is_square())
+        throw std::invalid_argument{"try to get trace of no square matrix"};
+    if ((what.min || what.max) && (mat.height() == 0 || mat.width() == 0))
+        throw std::invalid_argument{"try to get min or max of empty matrix"};
+    if constexpr (!detail::is_less_comparable<T>)
+        if (what.min || what.max)
+            throw std::invalid_argument{"try to get min or max of elements without operator<"};
+
+    MATRIX_PROFILE_SCOPE("reduce");
+    const size_type width = mat.width();
+    Reductions<T, abs_t> res;
+    if (what.row_sums)
+        res.row_sums = DenseVector<T>(mat.height());
+
+    // two terms (part and its rounding error) of every row for accurate summation
+    const bool is_accurate = detail::has_accurate_summation<T, abs_t> && what.summation != Summation::naive;
+    std::vector<T> sum_terms ((is_accurate && what.sum) ? 2 * mat.height() : 0);
+    std::vector<T> trace_terms ((is_accurate && what.trace) ? 2 * mat.height() : 0);
+    std::vector<T> square_terms ((is_accurate && what.frobenius) ? 2 * mat.height() : 0);
+
+    struct Partial
+    {
+        T sum {}, trace {};
+        abs_t sum_of_squares {}, norm_inf {}, norm_max {};
+        std::vector<T> col_sums {};
+        std::vector<abs_t> col_abs_sums {};
+        ElementPosition<T> min {}, max {};
+    };
+    // blocks of rows are fixed by width and not by threads, partial of every block is summed in the same order
+    const size_type block_rows = detail::rows_per_chunk(width);
+    std::vector<Partial> partials ((mat.height() + block_rows - 1) / block_rows);
+    Abs abs {};
+
+    auto reduce_block = [&](size_type block)
+    {
+        const size_type first = block * block_rows, last = std::min(mat.height(), first + block_rows);
+        auto& part = partials[block];
+        if (what.col_sums)
+            part.col_sums.assign(width, T{});
+        if (what.norm_1)
+            part.col_abs_sums.assign(width, abs_t{});
+        if (what.min || what.max)
+            part.min = part.max = {mat.to(first, 0), first, 0};
+
+        for (size_type i = first; i < last; i++)
+        {
+            auto row = mat[i].begin();
+            if (what.sum || what.row_sums)
+            {
+                T row_sum;
+                if (is_accurate && what.sum)
+                    row_sum = detail::accurate_part<T>(mat[i].data(), nullptr, width, what.summation, &sum_terms[2 * i]);
+                else
+                    row_sum = detail::lanes_sum<T>(row, width, [](const T& elem) -> const T& {return elem;});
+                if (what.row_sums)
+                    res.row_sums[i] = row_sum;
+                part.sum += row_sum;
+            }
+            if (what.trace)
+            {
+                if (is_accurate)
+                    trace_terms[2 * i] = row[i];
+                part.trace += row[i];
+            }
+            if (what.frobenius)
+            {
+                abs_t squares {};
+                if constexpr (detail::has_accurate_summation<T, abs_t>)
+                    if (is_accurate)
+                        squares = detail::accurate_part<T>(mat[i].data(), mat[i].data(), width, what.summation, &square_terms[2 * i]);
+                if (!is_accurate)
+                    squares = detail::lanes_sum<abs_t>(row, width, [&](const T& elem)
+                    {
+                        auto elem_abs = abs(elem);
+                        return elem_abs * elem_abs;
+                    });
+                part.sum_of_squares += squares;
+            }
+            if (what.norm_inf)
+                detail::update_max(part.norm_inf, detail::lanes_sum<abs_t>(row, width, abs));
+            if (what.norm_max)
+                for (size_type j = 0; j < width; j++)
+                    detail::update_max(part.norm_max, abs(row[j]));
+            if (what.col_sums)
+                for (size_type j = 0; j < width; j++)
+                    part.col_sums[j] += row[j];
+            if (what.norm_1)
+                for (size_type j = 0; j < width; j++)
+                    part.col_abs_sums[j] += abs(row[j]);
+            if constexpr (detail::is_less_comparable<T>)
+                if (what.min || what.max)
+                    for (size_type j = 0; j < width; j++)
+                    {
+                        if (row[j] < part.min.value)
+                            part.min = {row[j], i, j};
+                        if (part.max.value < row[j])
+                            part.max = {row[j], i, j};
+                    }
+        }
+    };
+    detail::parallel_for(0, partials.size(), [&](size_type first, size_type last)
+    {
+        for (size_type block = first; block < last; block++)
+            reduce_block(block);
+    });
+
+    // partials are combined in order of blocks
+    std::vector<abs_t> col_abs_sums (what.norm_1 ? width : 0);
+    if (what.col_sums)
+        res.col_sums = DenseVector<T>(width);
+    for (size_type p = 0; p < partials.size(); p++)
+    {
+        auto& part = partials[p];
+        res.sum += part.sum;
+        res.trace += part.trace;
+        res.sum_of_squares += part.sum_of_squares;
+        detail::update_max(res.norm_inf, part.norm_inf);
+        detail::update_max(res.norm_max, part.norm_max);
+        for (size_type j = 0; j < part.col_sums.size(); j++)
+            res.col_sums[j] += part.col_sums[j];
+        for (size_type j = 0; j < part.col_abs_sums.size(); j++)
+            col_abs_sums[j] += part.col_abs_sums[j];
+        if constexpr (detail::is_less_comparable<T>)
+        {
+            if (p == 0 || part.min.value < res.min.value)
+                res.min = part.min;
+            if (p == 0 || res.max.value < part.max.value)
+                res.max = part.max;
+        }
+    }
+    for (const auto& col_sum: col_abs_sums)
+        detail::update_max(res.norm_1, col_sum);
+    if constexpr (detail::has_accurate_summation<T, abs_t>)
+        if (is_accurate)
+        {
+            if (what.sum)
+                res.sum = detail::accurate_total(sum_terms, what.summation);
+            if (what.trace)
+                res.trace = detail::accurate_total(trace_terms, what.summation);
+            if (what.frobenius)
+                res.sum_of_squares = detail::accurate_total(square_terms, what.summation);
+        }
+
+    MATRIX_PROFILE_FLOPS(mat.height() * width);
+    return res;
+}
+
+//--------------------------------=| Single reductions start |=-----------------------------------------
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+T sum(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return reduce(mat, {.sum = true}).sum;
+}
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+T trace(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return reduce(mat, {.trace = true}).trace;
+}
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+auto frobenius_norm(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return std::sqrt(reduce(mat, {.frobenius = true}).sum_of_squares);
+}
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+detail::abs_type<T, Abs> norm_1(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return reduce(mat, {.norm_1 = true}).norm_1;
+}
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+detail::abs_type<T, Abs> norm_inf(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return reduce(mat, {.norm_inf = true}).norm_inf;
+}
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+detail::abs_type<T, Abs> norm_max(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return reduce(mat, {.norm_max = true}).norm_max;
+}
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+DenseVector<T> row_sums(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return reduce(mat, {.row_sums = true}).row_sums;
+}
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+DenseVector<T> col_sums(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return reduce(mat, {.col_sums = true}).col_sums;
+}
+
+// first position of min in row order
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+ElementPosition<T> argmin(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return reduce(mat, {.min = true}).min;
+}
+
+// first position of max in row order
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+ElementPosition<T> argmax(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    return reduce(mat, {.max = true}).max;
+}
+
+// floating point sum, trace and frobenius norm with given summation
+template<std::floating_point T, bool IsDivArithm, class Cmp, class Abs>
+T sum(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat, Summation mode)
+{
+    return reduce(mat, {.sum = true, .summation = mode}).sum;
+}
+
+template<std::floating_point T, bool IsDivArithm, class Cmp, class Abs>
+T trace(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat, Summation mode)
+{
+    return reduce(mat, {.trace = true, .summation = mode}).trace;
+}
+
+template<std::floating_point T, bool IsDivArithm, class Cmp, class Abs>
+auto frobenius_norm(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat, Summation mode)
+{
+    return std::sqrt(reduce(mat, {.frobenius = true, .summation = mode}).sum_of_squares);
+}
+//--------------------------------=| Single reductions end |=-------------------------------------------
+
+// lhs == rhs or |lhs - rhs| <= abs_tol + rel_tol * max(|lhs|, |rhs|) for all elements
+// (equal infinities match, NaN never matches),
+// chunks of rows are checked in parallel and first mismatch stops all of them
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+bool approx_equal(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs, const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs,
+                  const detail::abs_type<T, Abs>& abs_tol, const detail::abs_type<T, Abs>& rel_tol = {})
+{
+    if (lhs.height() != rhs.height() || lhs.width() != rhs.width())
+        return false;
+
+    MATRIX_PROFILE_SCOPE("approx_equal");
+    Abs abs {};
+    std::atomic<bool> is_equal {true};
+    detail::parallel_for(0, lhs.height(), [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last && is_equal.load(std::memory_order_relaxed); i++)
+        {
+            auto lhs_row = lhs[i].begin();
+            auto rhs_row = rhs[i].begin();
+            bool is_row_equal = true;
+            for (std::size_t j = 0; j < lhs.width(); j++)
+            {
+                if (lhs_row[j] == rhs_row[j])
+                    continue;
+                auto lhs_abs = abs(lhs_row[j]), rhs_abs = abs(rhs_row[j]);
+                auto bound = abs_tol + rel_tol * ((lhs_abs < rhs_abs) ? rhs_abs : lhs_abs);
+                is_row_equal &= (abs(lhs_row[j] - rhs_row[j]) <= bound);
+            }
+            if (!is_row_equal)
+                is_equal.store(false, std::memory_order_relaxed);
+        }
+    }, detail::rows_per_chunk(lhs.width()));
+    return is_equal.load();
+}
+
+} // namespace Matrix
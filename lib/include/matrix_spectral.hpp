@@ -0,0 +1,717 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "matrix_arithmetic.hpp"
+#include "matrix_parallel.hpp"
+#include "matrix_qr.hpp"
+#include "matrix_storage.hpp"
+#include "matrix_strassen.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Spectral decompositions for floating point matrices.                         |
+ * eigen_symmetric(): blocked Householder tridiagonalization + implicit QL.      |
+ * svd(): blocked Householder bidiagonalization + implicit shift QR.            |
+ * Reductions go by panels of reflectors: panel is built by matrix-vector       |
+ * products and trailing matrix is updated once per panel by rank 2k product    |
+ * (A -= V * W^T + W * V^T, A -= V * Y^T + X * U^T). Orthogonal factors are     |
+ * accumulated from blocks of reflectors in compact WY form of matrix_qr.hpp.   |
+ * All these products are done by kernel of matrix_strassen.hpp on chunks of    |
+ * rows in parallel. Rotations of every QL/QR iteration are saved and applied  |
+ * to rows of vectors after it, chunks of columns in parallel.                  |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+struct EigenDecomposition
+{
+    std::vector<T> values;                               // ascending order
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> vectors;  // i-th column is eigenvector of values[i]
+};
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+struct SVDecomposition
+{
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> u;  // m x r, r = min(m, n)
+    std::vector<T> singular_values;                // r values in descending order
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> v;  // n x r, A = U * diag(s) * V^T
+};
+
+namespace detail
+{
+
+// columns of one panel of reflectors
+constexpr std::size_t spectral_block_size = 32;
+
+// row-major buffer with padded stride
+template<typename T>
+class RowBuffer
+{
+    std::size_t height_, width_, stride_;
+    aligned_vector<T> data_;
+
+public:
+    RowBuffer(std::size_t m, std::size_t n)
+    :height_ {m}, width_ {n}, stride_ {padded_stride<T>(n)}, data_ (m * stride_)
+    {}
+
+    std::size_t height() const {return height_;}
+    std::size_t width()  const {return width_;}
+
+    T&       operator()(std::size_t i, std::size_t j)       {return data_[i * stride_ + j];}
+    const T& operator()(std::size_t i, std::size_t j) const {return data_[i * stride_ + j];}
+    T*       row(std::size_t i)       {return data_.data() + i * stride_;}
+    const T* row(std::size_t i) const {return data_.data() + i * stride_;}
+
+    BlockView<T> view(std::size_t i, std::size_t j) {return {row(i) + j, stride_};}
+};
+
+// c -= a * b, a is m x k, b is k x n: chunks of rows of c in parallel, every chunk by classical kernel
+template<typename T>
+void subtract_product(BlockView<T> a, BlockView<T> b, BlockView<T> c, std::size_t m, std::size_t k, std::size_t n)
+{
+    if (m == 0 || k == 0 || n == 0)
+        return;
+
+    MATRIX_PROFILE_FLOPS(2 * m * k * n);
+    parallel_for(0, m, [&](std::size_t first, std::size_t last)
+    {
+        aligned_vector<T> prod ((last - first) * n);
+        StrassenWinograd<T> {0}(a.sub(first, 0), b, {prod.data(), n}, last - first, k, n, 0);
+        for (std::size_t i = first; i < last; i++)
+        {
+            T* c_row = c.ptr + i * c.ld;
+            const T* prod_row = prod.data() + (i - first) * n;
+            for (std::size_t j = 0; j < n; j++)
+                c_row[j] -= prod_row[j];
+        }
+    }, rows_per_chunk(n));
+}
+
+// rows [first, height) of q are multiplied by transposed block of jb reflectors: q = q * (I - V * T^T * V^T),
+// k-th reflector is elem(k, i) for i >= first + k with elem(k, first + k) = 1, rows before first and
+// columns before first of q are not changed by them
+template<typename T, typename Elem>
+void apply_reflectors_right(RowBuffer<T>& q, std::size_t first, std::size_t jb, const T* tau, Elem elem)
+{
+    const std::size_t n_rows = q.height() - first, len = q.width() - first;
+
+    // explicit V (len x jb), V^T and T^T, all row-major
+    aligned_vector<T> vr (len * jb), vt (jb * len), tt (jb * jb);
+    for (std::size_t k = 0; k < jb; k++)
+        for (std::size_t i = k; i < len; i++)
+            vr[i * jb + k] = vt[k * len + i] = elem(k, first + i);
+    auto t = block_reflector_factor(tau, jb, [&](std::size_t i, std::size_t k)
+    {
+        return std::inner_product(vt.begin() + i * len + i, vt.begin() + (i + 1) * len, vt.begin() + k * len + i, T{});
+    });
+    for (std::size_t r = 0; r < jb; r++)
+        for (std::size_t k = r; k < jb; k++)
+            tt[k * jb + r] = t[r * jb + k];
+
+    MATRIX_PROFILE_FLOPS(4 * n_rows * len * jb);
+    BlockView<T> rows = q.view(first, first);
+    parallel_for(0, n_rows, [&](std::size_t row_begin, std::size_t row_end)
+    {
+        const std::size_t nr = row_end - row_begin;
+        aligned_vector<T> qv (nr * jb), y (nr * jb), d (nr * len);
+        StrassenWinograd<T> gemm {0};
+        gemm(rows.sub(row_begin, 0), {vr.data(), jb}, {qv.data(), jb}, nr, len, jb, 0);
+        gemm({qv.data(), jb}, {tt.data(), jb}, {y.data(), jb}, nr, jb, jb, 0);
+        gemm({y.data(), jb}, {vt.data(), len}, {d.data(), len}, nr, jb, len, 0);
+        for (std::size_t i = 0; i < nr; i++)
+        {
+            T* q_row = rows.ptr + (row_begin + i) * rows.ld;
+            const T* d_row = d.data() + i * len;
+            for (std::size_t j = 0; j < len; j++)
+                q_row[j] -= d_row[j];
+        }
+    }, rows_per_chunk(len));
+}
+
+// rows x len matrix of first rows of E^T * H_(count-1) * ... * H_0 = (H_0 * ... * H_(count-1) * E)^T,
+// k-th reflector is elem(k, i) for i >= offset + k, blocks of them are applied from the last one
+template<typename T, typename Elem>
+RowBuffer<T> accumulate_reflectors(std::size_t rows, std::size_t len, std::size_t offset, std::size_t count,
+                                   const T* tau, Elem elem)
+{
+    RowBuffer<T> q (rows, len);
+    for (std::size_t i = 0; i < std::min(rows, len); i++)
+        q(i, i) = T{1};
+    for (std::size_t blk = (count + spectral_block_size - 1) / spectral_block_size; blk-- > 0;)
+    {
+        const std::size_t j0 = blk * spectral_block_size, jb = std::min(spectral_block_size, count - j0);
+        apply_reflectors_right(q, offset + j0, jb, tau + j0, [&](std::size_t k, std::size_t i) {return elem(j0 + k, i);});
+    }
+    return q;
+}
+
+template<typename T>
+struct PlaneRotation
+{
+    std::size_t row;
+    T c, s;  // rows row and row + 1: (x, y) -> (c * x - s * y, s * x + c * y)
+};
+
+// rotations are applied to rows of buf in their order, chunks of columns in parallel
+template<typename T>
+void rotate_rows(RowBuffer<T>& buf, const std::vector<PlaneRotation<T>>& rots)
+{
+    parallel_for(0, buf.width(), [&](std::size_t first, std::size_t last)
+    {
+        for (const auto& rot: rots)
+        {
+            T* x = buf.row(rot.row);
+            T* y = buf.row(rot.row + 1);
+            const T c = rot.c, s = rot.s;
+            for (std::size_t k = first; k < last; k++)
+            {
+                T tmp = x[k];
+                x[k] = c * tmp - s * y[k];
+                y[k] = s * tmp + c * y[k];
+            }
+        }
+    }, std::max<std::size_t>(64, rows_per_chunk(rots.size())));
+}
+
+/*
+ * Householder reduction of symmetric a (both triangles are kept) to tridiagonal d, e (e[i] couples i - 1
+ * and i, e[0] = 0). Row c is updated by previous columns of its panel: a(c, c:n) -= V(c:n) * W(c)^T +
+ * W(c:n) * V(c)^T, its reflector v is built and w = tau * (A * v - V * (W^T * v) - W * (V^T * v)) - alpha * v,
+ * where A * v is done by rows of a which panel has not changed yet. Trailing rows are updated once per
+ * panel: A -= V * W^T + W * V^T, both triangles, so every row stays contiguous for A * v.
+ * On exit row c holds reflector c from column c + 1 with explicit leading 1, tau[c] is its coefficient.
+ */
+template<typename T>
+void tridiagonalize(RowBuffer<T>& a, std::vector<T>& d, std::vector<T>& e, std::vector<T>& tau)
+{
+    const std::size_t n = d.size();
+    e[0] = T{};
+    for (std::size_t j0 = 0; j0 < n; j0 += spectral_block_size)
+    {
+        const std::size_t jb = std::min(spectral_block_size, n - j0);
+        // rows [0, jb) are w and rows [jb, 2 * jb) are v of columns of panel, zero up to column c + 1
+        RowBuffer<T> wv (2 * jb, n);
+        std::vector<T> p (jb), q (jb);
+
+        for (std::size_t i = 0; i < jb; i++)
+        {
+            const std::size_t c = j0 + i;
+            T* a_c = a.row(c);
+            for (std::size_t k = 0; k < i; k++)
+            {
+                const T* w_k = wv.row(k);
+                const T* v_k = wv.row(jb + k);
+                const T w_kc = w_k[c], v_kc = v_k[c];
+                for (std::size_t s = c; s < n; s++)
+                    a_c[s] -= v_k[s] * w_kc + w_k[s] * v_kc;
+            }
+            d[c] = a_c[c];
+            if (c + 1 == n)
+                break;
+
+            tau[c] = make_householder(a_c[c + 1], a_c + c + 2, n - c - 2, 1);
+            e[c + 1] = a_c[c + 1];
+            a_c[c + 1] = T{1};
+            T* w = wv.row(i);
+            T* v = wv.row(jb + i);
+            std::copy(a_c + c + 1, a_c + n, v + c + 1);
+            if (tau[c] == T{})
+                continue;
+
+            parallel_for(c + 1, n, [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t r = first; r < last; r++)
+                    w[r] = std::inner_product(a.row(r) + c + 1, a.row(r) + n, v + c + 1, T{});
+            }, rows_per_chunk(n - c));
+            for (std::size_t k = 0; k < i; k++)
+            {
+                p[k] = std::inner_product(wv.row(k) + c + 1, wv.row(k) + n, v + c + 1, T{});
+                q[k] = std::inner_product(wv.row(jb + k) + c + 1, wv.row(jb + k) + n, v + c + 1, T{});
+            }
+            for (std::size_t k = 0; k < i; k++)
+            {
+                const T* w_k = wv.row(k);
+                const T* v_k = wv.row(jb + k);
+                for (std::size_t r = c + 1; r < n; r++)
+                    w[r] -= v_k[r] * p[k] + w_k[r] * q[k];
+            }
+            for (std::size_t r = c + 1; r < n; r++)
+                w[r] *= tau[c];
+            T alpha = -tau[c] / 2 * std::inner_product(w + c + 1, w + n, v + c + 1, T{});
+            for (std::size_t r = c + 1; r < n; r++)
+                w[r] += alpha * v[r];
+        }
+
+        const std::size_t tail = j0 + jb, n_tail = n - tail;
+        if (n_tail == 0)
+            continue;
+        // [V W] * [W V]^T, right operand is wv itself
+        aligned_vector<T> vw (n_tail * 2 * jb);
+        for (std::size_t r = 0; r < n_tail; r++)
+            for (std::size_t k = 0; k < jb; k++)
+            {
+                vw[r * 2 * jb + k] = wv(jb + k, tail + r);
+                vw[r * 2 * jb + jb + k] = wv(k, tail + r);
+            }
+        subtract_product<T>({vw.data(), 2 * jb}, wv.view(0, tail), a.view(tail, tail), n_tail, 2 * jb, n_tail);
+    }
+}
+
+// implicit QL iterations on tridiagonal matrix, z holds eigenvectors in rows (transposed),
+// throws if there are more than 30 * n iterations
+template<typename T>
+void tridiagonal_ql(RowBuffer<T>& z, std::vector<T>& d, std::vector<T>& e)
+{
+    const std::size_t n = d.size();
+    for (std::size_t i = 1; i < n; i++)
+        e[i - 1] = e[i];
+    e[n - 1] = T{};
+
+    T f {}, tst1 {};
+    const T eps = std::numeric_limits<T>::epsilon();
+    const std::size_t max_iterations = 30 * n;
+    std::size_t n_iterations = 0;
+    std::vector<PlaneRotation<T>> rots;
+    for (std::size_t l = 0; l < n; l++)
+    {
+        tst1 = std::max(tst1, std::abs(d[l]) + std::abs(e[l]));
+        std::size_t m = l;
+        while (m + 1 < n && std::abs(e[m]) > eps * tst1)
+            m++;
+
+        if (m > l)
+        {
+            do
+            {
+                if (++n_iterations > max_iterations)
+                    throw std::runtime_error{"QL iterations of eigen_symmetric don't converge"};
+
+                T g = d[l];
+                T p = (d[l + 1] - g) / (2 * e[l]);
+                T r = std::hypot(p, T{1});
+                if (p < 0)
+                    r = -r;
+                d[l] = e[l] / (p + r);
+                d[l + 1] = e[l] * (p + r);
+                T dl1 = d[l + 1];
+                T h = g - d[l];
+                for (std::size_t i = l + 2; i < n; i++)
+                    d[i] -= h;
+                f += h;
+
+                p = d[m];
+                T c = 1, c2 = 1, c3 = 1, s = 0, s2 = 0;
+                T el1 = e[l + 1];
+                rots.clear();
+                for (std::size_t i = m - 1; static_cast<long long>(i) >= static_cast<long long>(l); i--)
+                {
+                    c3 = c2;
+                    c2 = c;
+                    s2 = s;
+                    g = c * e[i];
+                    h = c * p;
+                    r = std::hypot(p, e[i]);
+                    e[i + 1] = s * r;
+                    s = e[i] / r;
+                    c = p / r;
+                    p = c * d[i] - s * g;
+                    d[i + 1] = h + s * (c * g + s * d[i]);
+                    rots.push_back({i, c, s});
+                }
+                rotate_rows(z, rots);
+                p = -s * s2 * c3 * el1 * e[l] / dl1;
+                e[l] = s * p;
+                d[l] = c * p;
+            }
+            while (std::abs(e[l]) > eps * tst1);
+        }
+        d[l] += f;
+        e[l] = T{};
+    }
+}
+
+/*
+ * Householder reduction of a (m x n, m >= n) to upper bidiagonal d, e (e[i] couples i and i + 1):
+ * A = Q * B * P^T. Panel is built as in LAPACK dlabrd: column c and row c are updated by previous
+ * columns of panel, its left reflector v gives column c of Y (n x jb) and its right reflector u gives
+ * column c of X (m x jb), then trailing A -= V * Y^T + X * U^T once per panel.
+ * On exit column c of a holds v from row c and row c holds u from column c + 1, both with explicit
+ * leading 1, tau_q and tau_p are their coefficients.
+ */
+template<typename T>
+void bidiagonalize(ColumnBuffer<T>& a, std::vector<T>& d, std::vector<T>& e, std::vector<T>& tau_q, std::vector<T>& tau_p)
+{
+    const std::size_t m = a.height(), n = a.width();
+    std::vector<T> t (spectral_block_size), u (n);
+    for (std::size_t j0 = 0; j0 < n; j0 += spectral_block_size)
+    {
+        const std::size_t jb = std::min(spectral_block_size, n - j0);
+        ColumnBuffer<T> x (m, jb), y (n, jb);
+
+        for (std::size_t i = 0; i < jb; i++)
+        {
+            const std::size_t c = j0 + i;
+            T* col = a.col(c);
+            // A(c:m, c) -= V * Y(c)^T + X * U(c)
+            for (std::size_t k = 0; k < i; k++)
+            {
+                const T* v_k = a.col(j0 + k);
+                const T* x_k = x.col(k);
+                const T y_ck = y(c, k), u_kc = a(j0 + k, c);
+                for (std::size_t r = c; r < m; r++)
+                    col[r] -= v_k[r] * y_ck + x_k[r] * u_kc;
+            }
+            tau_q[c] = make_householder(col[c], col + c + 1, m - c - 1, 1);
+            d[c] = col[c];
+            col[c] = T{1};
+            if (c + 1 == n)
+            {
+                e[c] = tau_p[c] = T{};
+                break;
+            }
+
+            // Y(c+1:n, i) = tau_q * (A^T * v - Y * (V^T * v) - U^T * (X^T * v))
+            T* y_i = y.col(i);
+            if (tau_q[c] != T{})
+            {
+                parallel_for(c + 1, n, [&](std::size_t first, std::size_t last)
+                {
+                    for (std::size_t j = first; j < last; j++)
+                        y_i[j] = std::inner_product(col + c, col + m, a.col(j) + c, T{});
+                }, rows_per_chunk(m - c));
+                for (std::size_t k = 0; k < i; k++)
+                {
+                    const T* y_k = y.col(k);
+                    T dot = std::inner_product(col + c, col + m, a.col(j0 + k) + c, T{});
+                    for (std::size_t j = c + 1; j < n; j++)
+                        y_i[j] -= y_k[j] * dot;
+                }
+                for (std::size_t k = 0; k < i; k++)
+                    t[k] = std::inner_product(col + c, col + m, x.col(k) + c, T{});
+                for (std::size_t j = c + 1; j < n; j++)
+                {
+                    const T* a_j = a.col(j);
+                    T sum {};
+                    for (std::size_t k = 0; k < i; k++)
+                        sum += a_j[j0 + k] * t[k];
+                    y_i[j] = tau_q[c] * (y_i[j] - sum);
+                }
+            }
+
+            // A(c, c+1:n) -= Y * V(c)^T + U^T * X(c)^T
+            for (std::size_t j = c + 1; j < n; j++)
+            {
+                const T* a_j = a.col(j);
+                T sum {};
+                for (std::size_t k = 0; k <= i; k++)
+                    sum += y(j, k) * a(c, j0 + k);
+                for (std::size_t k = 0; k < i; k++)
+                    sum += a_j[j0 + k] * x(c, k);
+                a(c, j) -= sum;
+            }
+            tau_p[c] = make_householder(a(c, c + 1), (c + 2 < n) ? &a(c, c + 2) : nullptr, n - c - 2, a.stride());
+            e[c] = a(c, c + 1);
+            a(c, c + 1) = T{1};
+            if (tau_p[c] == T{})
+                continue;
+
+            // X(c+1:m, i) = tau_p * (A * u - V * (Y^T * u) - X * (U * u))
+            for (std::size_t j = c + 1; j < n; j++)
+                u[j] = a(c, j);
+            T* x_i = x.col(i);
+            parallel_for(c + 1, m, [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t j = c + 1; j < n; j++)
+                {
+                    const T* a_j = a.col(j);
+                    for (std::size_t r = first; r < last; r++)
+                        x_i[r] += a_j[r] * u[j];
+                }
+            }, rows_per_chunk(n - c));
+            for (std::size_t k = 0; k <= i; k++)
+            {
+                T dot = std::inner_product(u.begin() + c + 1, u.end(), y.col(k) + c + 1, T{});
+                const T* v_k = a.col(j0 + k);
+                for (std::size_t r = c + 1; r < m; r++)
+                    x_i[r] -= v_k[r] * dot;
+            }
+            for (std::size_t k = 0; k < i; k++)
+            {
+                T dot {};
+                for (std::size_t j = c + 1; j < n; j++)
+                    dot += a(j0 + k, j) * u[j];
+                const T* x_k = x.col(k);
+                for (std::size_t r = c + 1; r < m; r++)
+                    x_i[r] -= x_k[r] * dot;
+            }
+            for (std::size_t r = c + 1; r < m; r++)
+                x_i[r] *= tau_p[c];
+        }
+
+        const std::size_t tail = j0 + jb, n_tail = n - tail, m_tail = m - tail;
+        if (n_tail == 0)
+            continue;
+        // column-major trailing A is row-major A^T: A^T -= [Y U^T] * [V X]^T
+        aligned_vector<T> lhs (n_tail * 2 * jb), rhs (2 * jb * m_tail);
+        for (std::size_t j = 0; j < n_tail; j++)
+            for (std::size_t k = 0; k < jb; k++)
+            {
+                lhs[j * 2 * jb + k] = y(tail + j, k);
+                lhs[j * 2 * jb + jb + k] = a(j0 + k, tail + j);
+            }
+        for (std::size_t k = 0; k < jb; k++)
+        {
+            std::copy(a.col(j0 + k) + tail, a.col(j0 + k) + m, rhs.begin() + k * m_tail);
+            std::copy(x.col(k) + tail, x.col(k) + m, rhs.begin() + (jb + k) * m_tail);
+        }
+        subtract_product<T>({lhs.data(), 2 * jb}, {rhs.data(), m_tail}, {a.col(tail) + tail, a.stride()},
+                            n_tail, 2 * jb, m_tail);
+    }
+}
+
+/*
+ * Implicit shift QR on upper bidiagonal s, e (e[i] couples i and i + 1, e[n - 1] = 0) with deflation
+ * and splitting as in Golub-Kahan-Reinsch SVD, rows of ut and vt are rotated as columns of U and V.
+ * On exit s are nonnegative and descending. Throws if there are more than 6 * n^2 QR steps.
+ */
+template<typename T>
+void bidiagonal_qr(std::vector<T>& s, std::vector<T>& e, RowBuffer<T>& ut, RowBuffer<T>& vt)
+{
+    const long long n = static_cast<long long>(s.size());
+    const T eps = std::numeric_limits<T>::epsilon(), tiny = std::numeric_limits<T>::min() / eps;
+    const std::size_t max_steps = 6 * s.size() * s.size();
+    std::size_t n_steps = 0;
+    std::vector<PlaneRotation<T>> u_rots, v_rots;
+
+    // rotation of rows i and j of buf: (x, y) -> (cs * x + sn * y, cs * y - sn * x)
+    auto rotate_pair = [](RowBuffer<T>& buf, std::size_t i, std::size_t j, T cs, T sn)
+    {
+        T* x = buf.row(i);
+        T* y = buf.row(j);
+        for (std::size_t k = 0; k < buf.width(); k++)
+        {
+            T tmp = cs * x[k] + sn * y[k];
+            y[k] = cs * y[k] - sn * x[k];
+            x[k] = tmp;
+        }
+    };
+
+    for (long long p = n; p > 0;)
+    {
+        // e[k] is negligible, k = -1 if there is no such
+        long long k = p - 2;
+        for (; k >= 0; k--)
+            if (std::abs(e[k]) <= tiny + eps * (std::abs(s[k]) + std::abs(s[k + 1])))
+            {
+                e[k] = T{};
+                break;
+            }
+
+        if (k == p - 2)
+        {
+            // s[p - 1] is converged: make it nonnegative and move it to its place
+            k = p - 1;
+            if (s[k] <= T{})
+            {
+                s[k] = -s[k] + T{};
+                std::transform(vt.row(k), vt.row(k) + vt.width(), vt.row(k), [](T elem) {return -elem;});
+            }
+            for (; k + 1 < n && s[k] < s[k + 1]; k++)
+            {
+                std::swap(s[k], s[k + 1]);
+                std::swap_ranges(vt.row(k), vt.row(k) + vt.width(), vt.row(k + 1));
+                std::swap_ranges(ut.row(k), ut.row(k) + ut.width(), ut.row(k + 1));
+            }
+            p--;
+            continue;
+        }
+
+        // s[ks] is negligible, ks = k if there is no such
+        long long ks = p - 1;
+        for (; ks > k; ks--)
+        {
+            T t = std::abs(e[ks]) + (ks != k + 1 ? std::abs(e[ks - 1]) : T{});
+            if (std::abs(s[ks]) <= tiny + eps * t)
+            {
+                s[ks] = T{};
+                break;
+            }
+        }
+
+        if (ks == p - 1)
+        {
+            // s[p - 1] is zero: chase e[p - 2] out by rotations from the right
+            T f = e[p - 2];
+            e[p - 2] = T{};
+            for (long long j = p - 2; j > k; j--)
+            {
+                T t = std::hypot(s[j], f), cs = s[j] / t, sn = f / t;
+                s[j] = t;
+                if (j != k + 1)
+                {
+                    f = -sn * e[j - 1];
+                    e[j - 1] = cs * e[j - 1];
+                }
+                rotate_pair(vt, j, p - 1, cs, sn);
+            }
+        }
+        else if (ks != k)
+        {
+            // s[ks] is zero: split at it by rotations from the left
+            T f = e[ks];
+            e[ks] = T{};
+            for (long long j = ks + 1; j < p; j++)
+            {
+                T t = std::hypot(s[j], f), cs = s[j] / t, sn = f / t;
+                s[j] = t;
+                f = -sn * e[j];
+                e[j] = cs * e[j];
+                rotate_pair(ut, j, ks, cs, sn);
+            }
+        }
+        else
+        {
+            // QR step on s[k+1:p] with shift from trailing 2 x 2 block
+            if (++n_steps > max_steps)
+                throw std::runtime_error{"QR iterations of svd don't converge"};
+
+            k++;
+            T scale = std::max({std::abs(s[p - 1]), std::abs(s[p - 2]), std::abs(e[p - 2]), std::abs(s[k]), std::abs(e[k])});
+            T sp = s[p - 1] / scale, spm1 = s[p - 2] / scale, epm1 = e[p - 2] / scale;
+            T sk = s[k] / scale, ek = e[k] / scale;
+            T b = ((spm1 + sp) * (spm1 - sp) + epm1 * epm1) / 2;
+            T c = (sp * epm1) * (sp * epm1);
+            T shift {};
+            if (b != T{} || c != T{})
+            {
+                shift = std::sqrt(b * b + c);
+                if (b < T{})
+                    shift = -shift;
+                shift = c / (b + shift);
+            }
+            T f = (sk + sp) * (sk - sp) + shift;
+            T g = sk * ek;
+
+            u_rots.clear();
+            v_rots.clear();
+            for (long long j = k; j < p - 1; j++)
+            {
+                T t = std::hypot(f, g), cs = f / t, sn = g / t;
+                if (j != k)
+                    e[j - 1] = t;
+                f = cs * s[j] + sn * e[j];
+                e[j] = cs * e[j] - sn * s[j];
+                g = sn * s[j + 1];
+                s[j + 1] = cs * s[j + 1];
+                v_rots.push_back({static_cast<std::size_t>(j), cs, -sn});
+
+                t = std::hypot(f, g);
+                cs = f / t;
+                sn = g / t;
+                s[j] = t;
+                f = cs * e[j] + sn * s[j + 1];
+                s[j + 1] = -sn * e[j] + cs * s[j + 1];
+                g = sn * e[j + 1];
+                e[j + 1] = cs * e[j + 1];
+                u_rots.push_back({static_cast<std::size_t>(j), cs, -sn});
+            }
+            e[p - 2] = f;
+            rotate_rows(vt, v_rots);
+            rotate_rows(ut, u_rots);
+        }
+    }
+}
+
+} // namespace detail
+
+template<std::floating_point T, bool IsDivArithm, class Cmp, class Abs>
+EigenDecomposition<T, IsDivArithm, Cmp, Abs> eigen_symmetric(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    if (!mat.is_square())
+        throw std::invalid_argument{"try to get eigen decomposition of no square matrix"};
+
+    const std::size_t n = mat.height();
+    Cmp cmp {};
+    for (std::size_t i = 0; i < n; i++)
+        for (std::size_t j = 0; j < i; j++)
+            if (!cmp(mat.to(i, j), mat.to(j, i)))
+                throw std::invalid_argument{"try to get eigen decomposition of no symmetric matrix"};
+
+    MATRIX_PROFILE_SCOPE("eigen_symmetric");
+    EigenDecomposition<T, IsDivArithm, Cmp, Abs> res {std::vector<T>(n), MatrixArithmetic<T, IsDivArithm, Cmp, Abs>(n, n)};
+    if (n == 0)
+        return res;
+
+    detail::RowBuffer<T> a (n, n);
+    for (std::size_t i = 0; i < n; i++)
+        std::copy(mat[i].begin(), mat[i].end(), a.row(i));
+
+    std::vector<T> e (n), tau (n);
+    detail::tridiagonalize(a, res.values, e, tau);
+    // rows of z are columns of Q = H_0 * ... * H_(n-2)
+    auto z = detail::accumulate_reflectors(n, n, 1, n - 1, tau.data(), [&](std::size_t k, std::size_t i) {return a(k, i);});
+    detail::tridiagonal_ql(z, res.values, e);
+
+    std::vector<std::size_t> order (n);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {return res.values[lhs] < res.values[rhs];});
+
+    std::vector<T> values (n);
+    for (std::size_t j = 0; j < n; j++)
+    {
+        values[j] = res.values[order[j]];
+        const T* vec = z.row(order[j]);
+        for (std::size_t i = 0; i < n; i++)
+            res.vectors.to(i, j) = vec[i];
+    }
+    res.values.swap(values);
+    return res;
+}
+
+template<std::floating_point T, bool IsDivArithm, class Cmp, class Abs>
+SVDecomposition<T, IsDivArithm, Cmp, Abs> svd(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+{
+    using matrix_type = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>;
+
+    if (mat.height() < mat.width())
+    {
+        auto res = svd(mat.transpos());
+        std::swap(res.u, res.v);
+        return res;
+    }
+
+    MATRIX_PROFILE_SCOPE("svd");
+    const std::size_t m = mat.height(), n = mat.width();
+    SVDecomposition<T, IsDivArithm, Cmp, Abs> res {matrix_type(m, n), std::vector<T>(n), matrix_type(n, n)};
+    if (n == 0)
+        return res;
+
+    auto a = detail::to_columns(mat, 0, m);
+    std::vector<T> e (n), tau_q (n), tau_p (n);
+    detail::bidiagonalize(a, res.singular_values, e, tau_q, tau_p);
+
+    // rows of ut are columns of thin Q, rows of vt are columns of P
+    auto ut = detail::accumulate_reflectors(n, m, 0, n, tau_q.data(), [&](std::size_t k, std::size_t i) {return a(i, k);});
+    auto vt = detail::accumulate_reflectors(n, n, 1, n - 1, tau_p.data(), [&](std::size_t k, std::size_t i) {return a(k, i);});
+    detail::bidiagonal_qr(res.singular_values, e, ut, vt);
+
+    for (std::size_t j = 0; j < n; j++)
+    {
+        for (std::size_t i = 0; i < m; i++)
+            res.u.to(i, j) = ut(j, i);
+        for (std::size_t i = 0; i < n; i++)
+            res.v.to(i, j) = vt(j, i);
+    }
+    return res;
+}
+
+} // namespace Matrix
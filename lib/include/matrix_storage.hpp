@@ -0,0 +1,242 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#if defined(MATRIX_HAS_NUMA)
+#include <numa.h>
+#endif
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Storage for internal buffers of kernels (Strassen, QR, spectral, accurate    |
+ * product): cache line aligned, big buffers are aligned to huge page and with  |
+ * MATRIX_HUGE_PAGES are advised to be backed by transparent huge pages, what   |
+ * reduces TLB misses on big matrices. Rows of buffers are padded to cache line |
+ * and stride multiple of 4 KiB is avoided (cache set aliasing).                 |
+ * Rows of MatrixContainer are allocated by AllocationPolicy of matrix: one by  |
+ * one from heap (default) or cut from one block with the same alignment,      |
+ * padding and optional huge pages as buffers of kernels. Block can be          |
+ * interleaved over NUMA nodes by libnuma (MATRIX_HAS_NUMA), otherwise its      |
+ * pages are placed by first touch of threads which build rows.                 |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+
+enum class NumaPlacement
+{
+    first_touch, // page goes to node of thread which writes it first: rows are built by pinned threads
+    interleave   // pages of block go round robin over all nodes, first_touch without libnuma
+};
+
+// how MatrixContainer allocates its rows, results of product() and LU take policy of their operand
+struct AllocationPolicy
+{
+    bool is_contiguous = false; // rows are cut from one block: cache line aligned, padded stride
+    bool huge_pages    = false; // block is aligned to 2 MiB and advised to be backed by transparent huge pages
+    NumaPlacement numa = NumaPlacement::first_touch; // interleave needs block too
+
+    bool uses_block() const {return is_contiguous || huge_pages || numa == NumaPlacement::interleave;}
+};
+
+namespace detail
+{
+
+constexpr std::size_t cache_line_size = 64;
+constexpr std::size_t huge_page_size  = std::size_t{2} << 20;
+constexpr std::size_t aliasing_stride = 4096;
+
+// ptr and bytes are multiples of huge page
+inline void advise_huge_pages([[maybe_unused]] void* ptr, [[maybe_unused]] std::size_t bytes)
+{
+#if defined(__linux__)
+    madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+}
+
+// mbind of not yet touched pages to all nodes round robin, false if libnuma is absent
+inline bool interleave_pages([[maybe_unused]] void* ptr, [[maybe_unused]] std::size_t bytes)
+{
+#if defined(MATRIX_HAS_NUMA)
+    if (numa_available() < 0)
+        return false;
+    numa_interleave_memory(ptr, bytes, numa_all_nodes_ptr);
+    return true;
+#else
+    return false;
+#endif
+}
+
+template<typename T>
+class AlignedAllocator
+{
+    static bool is_huge(std::size_t bytes) {return bytes >= huge_page_size;}
+
+    static std::size_t alignment(std::size_t bytes)
+    {
+        return std::max({is_huge(bytes) ? huge_page_size : cache_line_size, alignof(T)});
+    }
+
+    // huge buffers are rounded up to whole huge pages to not share them with other allocations
+    static std::size_t alloc_size(std::size_t bytes)
+    {
+        return is_huge(bytes) ? (bytes + huge_page_size - 1) / huge_page_size * huge_page_size : bytes;
+    }
+
+public:
+    using value_type = T;
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length{};
+        std::size_t bytes = n * sizeof(T);
+        void* ptr = ::operator new(alloc_size(bytes), std::align_val_t{alignment(bytes)});
+#if defined(MATRIX_HUGE_PAGES)
+        if (is_huge(bytes))
+            advise_huge_pages(ptr, alloc_size(bytes));
+#endif
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept
+    {
+        std::size_t bytes = n * sizeof(T);
+        ::operator delete(ptr, alloc_size(bytes), std::align_val_t{alignment(bytes)});
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U>&) const noexcept {return true;}
+};
+
+template<typename T>
+using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
+// number of elements between starts of rows with width elements
+template<typename T>
+std::size_t padded_stride(std::size_t width)
+{
+    if (cache_line_size % sizeof(T) != 0)
+        return width;
+    constexpr std::size_t line = cache_line_size / sizeof(T);
+    std::size_t stride = (width + line - 1) / line * line;
+    if (stride * sizeof(T) % aliasing_stride == 0)
+        stride += line;
+    return stride;
+}
+
+/*
+ * One allocation for all rows of matrix: row i takes slot i of slot_bytes. Memory is not touched
+ * here, so pages are placed by threads which construct rows.
+ */
+class RowBlock
+{
+    std::size_t n_slots_, slot_bytes_, bytes_, alignment_;
+    std::unique_ptr<std::atomic<bool>[]> is_taken_;
+    std::byte* data_;
+
+public:
+    RowBlock(std::size_t n_slots, std::size_t slot_bytes, bool huge_pages, bool is_interleaved)
+    :n_slots_ {n_slots}, slot_bytes_ {std::max<std::size_t>(slot_bytes, 1)}, bytes_ {n_slots_ * slot_bytes_},
+     alignment_ {huge_pages ? huge_page_size : cache_line_size}, is_taken_ {new std::atomic<bool>[n_slots_] {}}
+    {
+        if (huge_pages)
+            bytes_ = (bytes_ + huge_page_size - 1) / huge_page_size * huge_page_size;
+        data_ = static_cast<std::byte*>(::operator new(bytes_, std::align_val_t{alignment_}));
+        if (huge_pages)
+            advise_huge_pages(data_, bytes_);
+        if (is_interleaved)
+            interleave_pages(data_, bytes_);
+    }
+
+    RowBlock(const RowBlock&) = delete;
+    RowBlock& operator=(const RowBlock&) = delete;
+
+    ~RowBlock() {::operator delete(data_, bytes_, std::align_val_t{alignment_});}
+
+    std::byte*  data()  const {return data_;}
+    std::size_t bytes() const {return bytes_;}
+
+    // memory of slot if it is free and big enough, nullptr otherwise
+    void* take(std::size_t slot, std::size_t bytes)
+    {
+        if (slot >= n_slots_ || bytes > slot_bytes_ || is_taken_[slot].exchange(true))
+            return nullptr;
+        return data_ + slot * slot_bytes_;
+    }
+
+    // false if ptr is not from block
+    bool give_back(void* ptr)
+    {
+        auto* byte_ptr = static_cast<std::byte*>(ptr);
+        if (byte_ptr < data_ || byte_ptr >= data_ + n_slots_ * slot_bytes_)
+            return false;
+        is_taken_[(byte_ptr - data_) / slot_bytes_].store(false);
+        return true;
+    }
+};
+
+/*
+ * Allocator of one row: takes its slot of block, otherwise (no block, slot is taken, row grows)
+ * goes to heap. Copy of row goes to heap too, moves and swaps carry allocator with memory.
+ */
+template<typename T>
+class RowAllocator
+{
+    template<typename U>
+    friend class RowAllocator;
+
+    std::shared_ptr<RowBlock> block_ {};
+    std::size_t slot_ = 0;
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    RowAllocator() = default;
+    RowAllocator(std::shared_ptr<RowBlock> block, std::size_t slot): block_ {std::move(block)}, slot_ {slot} {}
+
+    template<typename U>
+    RowAllocator(const RowAllocator<U>& other) noexcept: block_ {other.block_}, slot_ {other.slot_} {}
+
+    RowAllocator select_on_container_copy_construction() const {return {};}
+
+    T* allocate(std::size_t n)
+    {
+        if (block_)
+            if (void* ptr = block_->take(slot_, n * sizeof(T)))
+                return static_cast<T*>(ptr);
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept
+    {
+        if (block_ && block_->give_back(ptr))
+            return;
+        std::allocator<T>{}.deallocate(ptr, n);
+    }
+
+    template<typename U>
+    bool operator==(const RowAllocator<U>& other) const noexcept {return block_ == other.block_;}
+};
+
+} // namespace detail
+} // namespace Matrix
@@ -0,0 +1,263 @@
+#pragma once
+#include "matrix_arithmetic.hpp"
+#include "matrix_parallel.hpp"
+#include "matrix_storage.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Strassen-Winograd product: 7 block products and 15 block additions on every  |
+ * level instead of 8 products. Recursion goes down to cutoff, where classical   |
+ * kernel is used. Dimensions are padded with zeros up to multiple of 2^depth,   |
+ * so any rectangular shapes are supported.                                      |
+ * For floating point types result is a bit less accurate than product().       |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+
+struct StrassenParams
+{
+    std::size_t cutoff         = 128; // blocks with some side not greater than cutoff go to classical kernel
+    std::size_t parallel_depth = 2;   // number of upper recursion levels where 7 sub-products run in parallel
+};
+
+namespace detail
+{
+
+template<typename T>
+struct BlockView
+{
+    T* ptr;
+    std::size_t ld;
+
+    T& operator()(std::size_t i, std::size_t j) const {return ptr[i * ld + j];}
+    BlockView sub(std::size_t i, std::size_t j) const {return {ptr + i * ld + j, ld};}
+};
+
+template<typename T>
+class StrassenWinograd
+{
+    using size_type = std::size_t;
+    using view = BlockView<T>;
+
+    std::size_t parallel_depth_;
+    aligned_vector<T> workspace_;
+
+    // C = A * B, A is m x k, B is k x n
+    static void classical(view a, view b, view c, size_type m, size_type k, size_type n)
+    {
+        for (size_type i = 0; i < m; i++)
+        {
+            T* c_row = c.ptr + i * c.ld;
+            std::fill(c_row, c_row + n, T{});
+            for (size_type p = 0; p < k; p++)
+            {
+                const T a_ip = a(i, p);
+                const T* b_row = b.ptr + p * b.ld;
+                for (size_type j = 0; j < n; j++)
+                    c_row[j] += a_ip * b_row[j];
+            }
+        }
+    }
+
+    static void add(view dst, view lhs, view rhs, size_type m, size_type n)
+    {
+        for (size_type i = 0; i < m; i++)
+            for (size_type j = 0; j < n; j++)
+                dst(i, j) = lhs(i, j) + rhs(i, j);
+    }
+
+    static void sub(view dst, view lhs, view rhs, size_type m, size_type n)
+    {
+        for (size_type i = 0; i < m; i++)
+            for (size_type j = 0; j < n; j++)
+                dst(i, j) = lhs(i, j) - rhs(i, j);
+    }
+
+    // workspace of one level: S1..S4 (m/2 x k/2), T1..T4 (k/2 x n/2), P1..P7 (m/2 x n/2)
+    static size_type level_size(size_type m, size_type k, size_type n)
+    {
+        return (4 * m * k + 4 * k * n + 7 * m * n) / 4;
+    }
+
+    size_type workspace_size(size_type m, size_type k, size_type n, size_type depth, size_type level) const
+    {
+        if (depth == 0)
+            return 0;
+        auto child = workspace_size(m / 2, k / 2, n / 2, depth - 1, level + 1);
+        return level_size(m, k, n) + ((level < parallel_depth_) ? 7 * child : child);
+    }
+
+    void multiply(view a, view b, view c, size_type m, size_type k, size_type n,
+                  size_type depth, size_type level, T* ws)
+    {
+        if (depth == 0)
+        {
+            classical(a, b, c, m, k, n);
+            return;
+        }
+
+        size_type hm = m / 2, hk = k / 2, hn = n / 2;
+        view a11 = a, a12 = a.sub(0, hk), a21 = a.sub(hm, 0), a22 = a.sub(hm, hk);
+        view b11 = b, b12 = b.sub(0, hn), b21 = b.sub(hk, 0), b22 = b.sub(hk, hn);
+        view c11 = c, c12 = c.sub(0, hn), c21 = c.sub(hm, 0), c22 = c.sub(hm, hn);
+
+        view s[4], t[4], p[7];
+        for (auto& blk: s) {blk = {ws, hk}; ws += hm * hk;}
+        for (auto& blk: t) {blk = {ws, hn}; ws += hk * hn;}
+        for (auto& blk: p) {blk = {ws, hn}; ws += hm * hn;}
+
+        add(s[0], a21, a22, hm, hk);
+        sub(s[1], s[0], a11, hm, hk);
+        sub(s[2], a11, a21, hm, hk);
+        sub(s[3], a12, s[1], hm, hk);
+        sub(t[0], b12, b11, hk, hn);
+        sub(t[1], b22, t[0], hk, hn);
+        sub(t[2], b22, b12, hk, hn);
+        sub(t[3], t[1], b21, hk, hn);
+
+        const view lhs[7] = {a11, a12, s[3], a22, s[0], s[1], s[2]};
+        const view rhs[7] = {b11, b21, b22, t[3], t[0], t[1], t[2]};
+
+        if (level < parallel_depth_)
+        {
+            auto child = workspace_size(hm, hk, hn, depth - 1, level + 1);
+            parallel_for(0, 7, [&](size_type first, size_type last)
+            {
+                for (size_type i = first; i < last; i++)
+                    multiply(lhs[i], rhs[i], p[i], hm, hk, hn, depth - 1, level + 1, ws + i * child);
+            });
+        }
+        else
+            for (size_type i = 0; i < 7; i++)
+                multiply(lhs[i], rhs[i], p[i], hm, hk, hn, depth - 1, level + 1, ws);
+
+        add(c11, p[0], p[1], hm, hn);  // U1 = P1 + P2
+        add(p[5], p[0], p[5], hm, hn); // U2 = P1 + P6
+        add(p[6], p[5], p[6], hm, hn); // U3 = U2 + P7
+        add(p[5], p[5], p[4], hm, hn); // U4 = U2 + P5
+        add(c12, p[5], p[2], hm, hn);  // U5 = U4 + P3
+        sub(c21, p[6], p[3], hm, hn);  // U6 = U3 - P4
+        add(c22, p[6], p[4], hm, hn);  // U7 = U3 + P5
+    }
+
+    // levels of 7-way parallelism beyond what covers all cores only multiply threads and workspace
+    static size_type useful_parallel_depth()
+    {
+        size_type depth = 0;
+        for (size_type tasks = 1; tasks < hardware_threads(); tasks *= 7)
+            depth++;
+        return depth;
+    }
+
+public:
+    explicit StrassenWinograd(std::size_t parallel_depth)
+    :parallel_depth_ {std::min(parallel_depth, useful_parallel_depth())}
+    {}
+
+    // a, b, c are padded row-major buffers, all sides are multiples of 2^depth
+    void operator()(view a, view b, view c, size_type m, size_type k, size_type n, size_type depth)
+    {
+        workspace_.resize(workspace_size(m, k, n, depth, 0));
+        multiply(a, b, c, m, k, n, depth, 0, workspace_.data());
+    }
+};
+
+} // namespace detail
+
+/*
+ * Reusable Strassen-Winograd product: padded copies of operands, result and workspace of
+ * kernel are kept between calls, so repeated products of the same shapes allocate nothing.
+ */
+template<typename T = int>
+class StrassenProduct
+{
+    using size_type = std::size_t;
+
+    StrassenParams params_;
+    detail::StrassenWinograd<T> kernel_;
+    detail::aligned_vector<T> a_, b_, c_;
+
+    // levels of recursion, 0 if classical product is better
+    size_type depth(size_type m, size_type k, size_type n) const
+    {
+        size_type cutoff = std::max<size_type>(params_.cutoff, 1);
+        size_type res = 0;
+        for (size_type min_side = std::min({m, k, n}); min_side > cutoff; min_side = (min_side + 1) / 2)
+            res++;
+        return res;
+    }
+
+public:
+    explicit StrassenProduct(const StrassenParams& params = {})
+    :params_ {params}, kernel_ {params.parallel_depth}
+    {}
+
+    const StrassenParams& params() const {return params_;}
+
+    // res = lhs * rhs, storage of res is reused if it has shape of result
+    template<bool IsDivArithm, class Cmp, class Abs>
+    void operator()(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs, const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs,
+                    MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& res)
+    {
+        if (lhs.is_scalar() || rhs.is_scalar())
+        {
+            res = product(lhs, rhs);
+            return;
+        }
+        if (lhs.width() != rhs.height())
+            throw std::invalid_argument{"in product_strassen: lhs.width() != rhs.height()"};
+
+        size_type m = lhs.height(), k = lhs.width(), n = rhs.width();
+        size_type levels = depth(m, k, n);
+        if (levels == 0)
+        {
+            res = product(lhs, rhs);
+            return;
+        }
+
+        MATRIX_PROFILE_SCOPE("product_strassen");
+        auto pad = [levels](size_type side) {return ((side + (size_type{1} << levels) - 1) >> levels) << levels;};
+        size_type pm = pad(m), pk = pad(k), pn = pad(n);
+
+        size_type lda = detail::padded_stride<T>(pk), ldb = detail::padded_stride<T>(pn), ldc = ldb;
+        size_type old_capacity = a_.capacity() + b_.capacity() + c_.capacity();
+        a_.assign(pm * lda, T{});
+        b_.assign(pk * ldb, T{});
+        c_.resize(pm * ldc);
+        if (a_.capacity() + b_.capacity() + c_.capacity() > old_capacity)
+            MATRIX_PROFILE_TEMPORARY((a_.capacity() + b_.capacity() + c_.capacity() - old_capacity) * sizeof(T));
+        for (size_type i = 0; i < m; i++)
+            std::copy(lhs[i].begin(), lhs[i].end(), a_.begin() + i * lda);
+        for (size_type i = 0; i < k; i++)
+            std::copy(rhs[i].begin(), rhs[i].end(), b_.begin() + i * ldb);
+
+        kernel_({a_.data(), lda}, {b_.data(), ldb}, {c_.data(), ldc}, pm, pk, pn, levels);
+
+        if (res.height() != m || res.width() != n)
+            res = MatrixArithmetic<T, IsDivArithm, Cmp, Abs>(m, n);
+        for (size_type i = 0; i < m; i++)
+            std::copy(c_.begin() + i * ldc, c_.begin() + i * ldc + n, res[i].begin());
+    }
+
+    template<bool IsDivArithm, class Cmp, class Abs>
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> operator()(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs,
+                                                          const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs)
+    {
+        MatrixArithmetic<T, IsDivArithm, Cmp, Abs> res;
+        (*this)(lhs, rhs, res);
+        return res;
+    }
+};
+
+// one-off product, use StrassenProduct to keep buffers between products
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+MatrixArithmetic<T, IsDivArithm, Cmp, Abs> product_strassen(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& lhs,
+                                                            const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& rhs,
+                                                            const StrassenParams& params = {})
+{
+    return StrassenProduct<T>{params}(lhs, rhs);
+}
+
+} // namespace Matrix
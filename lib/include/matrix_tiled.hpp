@@ -0,0 +1,497 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "matrix_arithmetic.hpp"
+#include "matrix_parallel.hpp"
+#include "matrix_storage.hpp"
+#include "matrix_vector.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Tiled storage: matrix is cut in square tiles of side Layout::tile_side, every |
+ * tile is contiguous and row-major inside, tiles are placed in order of layout |
+ * policy: RowMajorTiles (row by row) or MortonTiles (Z-order, neighbour tiles  |
+ * are close at every scale, so any blocked walk keeps locality at every cache  |
+ * level). Walk along column still touches one cache line per row, but lines of |
+ * one tile are in tile_side^2 contiguous elements, so it touches fewer pages.  |
+ * Border tiles are padded with zeros. product(), transpos() and lu() work on   |
+ * tiles natively, to_row_major<>() and constructor from MatrixContainer        |
+ * convert from and to usual matrices.                                          |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+
+namespace detail
+{
+
+// bits of x go to even positions
+inline std::uint64_t spread_bits(std::uint64_t x)
+{
+    x &= 0xffffffff;
+    x = (x | (x << 16)) & 0x0000ffff0000ffff;
+    x = (x | (x << 8))  & 0x00ff00ff00ff00ff;
+    x = (x | (x << 4))  & 0x0f0f0f0f0f0f0f0f;
+    x = (x | (x << 2))  & 0x3333333333333333;
+    x = (x | (x << 1))  & 0x5555555555555555;
+    return x;
+}
+
+inline std::uint64_t morton_code(std::size_t i, std::size_t j)
+{
+    return (spread_bits(i) << 1) | spread_bits(j);
+}
+
+} // namespace detail
+
+//--------------------------------=| Layouts start |=---------------------------------------------------
+// tile_positions(h, w)[ti * w + tj] is position of tile (ti, tj) in storage, tile_side is power of 2
+template<std::size_t TileSide = 32>
+struct RowMajorTiles
+{
+    static constexpr std::size_t tile_side = TileSide;
+
+    static std::vector<std::size_t> tile_positions(std::size_t tiles_height, std::size_t tiles_width)
+    {
+        std::vector<std::size_t> res (tiles_height * tiles_width);
+        std::iota(res.begin(), res.end(), std::size_t{0});
+        return res;
+    }
+};
+
+// tiles go in Z-order, grid which is not square of power of 2 is compacted without gaps
+template<std::size_t TileSide = 32>
+struct MortonTiles
+{
+    static constexpr std::size_t tile_side = TileSide;
+
+    static std::vector<std::size_t> tile_positions(std::size_t tiles_height, std::size_t tiles_width)
+    {
+        std::vector<std::size_t> order (tiles_height * tiles_width);
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        std::sort(order.begin(), order.end(), [tiles_width](std::size_t lhs, std::size_t rhs)
+        {
+            return detail::morton_code(lhs / tiles_width, lhs % tiles_width) <
+                   detail::morton_code(rhs / tiles_width, rhs % tiles_width);
+        });
+
+        std::vector<std::size_t> res (order.size());
+        for (std::size_t pos = 0; pos < order.size(); pos++)
+            res[order[pos]] = pos;
+        return res;
+    }
+};
+//--------------------------------=| Layouts end |=-----------------------------------------------------
+
+template<typename T = int, class Layout = MortonTiles<>>
+class TiledMatrix
+{
+public:
+    using size_type       = std::size_t;
+    using value_type      = T;
+    using reference       = T&;
+    using const_reference = const T&;
+    using layout_type     = Layout;
+
+    static constexpr size_type tile_side = Layout::tile_side;
+    static constexpr size_type tile_area = tile_side * tile_side;
+    static_assert(tile_side > 0 && (tile_side & (tile_side - 1)) == 0, "side of tile has to be power of 2");
+
+private:
+    size_type height_ = 0, width_ = 0, tiles_height_ = 0, tiles_width_ = 0;
+    std::vector<size_type> tile_pos_ {}; // position in storage of tile (ti, tj)
+    std::vector<size_type> tile_at_ {};  // tile ti * tiles_width + tj at position in storage
+    detail::aligned_vector<value_type> data_ {};
+
+public:
+//--------------------------------=| Ctors start |=-----------------------------------------------------
+    TiledMatrix() = default;
+
+    TiledMatrix(size_type h, size_type w)
+    :height_ {h}, width_ {w},
+     tiles_height_ {(h + tile_side - 1) / tile_side}, tiles_width_ {(w + tile_side - 1) / tile_side},
+     tile_pos_ (Layout::tile_positions(tiles_height_, tiles_width_)), tile_at_ (tile_pos_.size()),
+     data_ (tile_pos_.size() * tile_area)
+    {
+        MATRIX_PROFILE_ALLOC(data_.size() * sizeof(value_type));
+        for (size_type ind = 0; ind < tile_pos_.size(); ind++)
+            tile_at_[tile_pos_[ind]] = ind;
+    }
+
+    TiledMatrix(size_type h, size_type w, const_reference val)
+    :TiledMatrix(h, w)
+    {
+        for (size_type i = 0; i < height_; i++)
+            for (size_type j = 0; j < width_; j++)
+                to(i, j) = val;
+    }
+
+    // from row-major matrix, segments of rows go to tiles
+    explicit TiledMatrix(const MatrixContainer<value_type>& mat)
+    :TiledMatrix(mat.height(), mat.width())
+    {
+        detail::parallel_for(0, tiles_height_, [&](size_type first, size_type last)
+        {
+            for (size_type i = first * tile_side; i < std::min(last * tile_side, height_); i++)
+            {
+                auto row = mat[i].begin();
+                for (size_type tj = 0; tj < tiles_width_; tj++)
+                {
+                    size_type len = std::min(tile_side, width_ - tj * tile_side);
+                    std::copy(row + tj * tile_side, row + tj * tile_side + len, tile_row(i, tj));
+                }
+            }
+        });
+    }
+//--------------------------------=| Ctors end |=-------------------------------------------------------
+
+//--------------------------------=| Conversions start |=-----------------------------------------------
+    template<bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> to_row_major() const
+    {
+        MatrixArithmetic<T, IsDivArithm, Cmp, Abs> res (height_, width_);
+        detail::parallel_for(0, tiles_height_, [&](size_type first, size_type last)
+        {
+            for (size_type i = first * tile_side; i < std::min(last * tile_side, height_); i++)
+            {
+                auto row = res[i].begin();
+                for (size_type tj = 0; tj < tiles_width_; tj++)
+                {
+                    size_type len = std::min(tile_side, width_ - tj * tile_side);
+                    const T* src = tile_row(i, tj);
+                    std::copy(src, src + len, row + tj * tile_side);
+                }
+            }
+        });
+        return res;
+    }
+//--------------------------------=| Conversions end |=-------------------------------------------------
+
+//--------------------------------=| Acces operators start |=-------------------------------------------
+    size_type height() const {return height_;}
+    size_type width()  const {return width_;}
+
+    size_type tiles_height() const {return tiles_height_;}
+    size_type tiles_width()  const {return tiles_width_;}
+    size_type tiles_num()    const {return tile_pos_.size();}
+
+    bool is_empty()  const {return height_ == 0 || width_ == 0;}
+    bool is_square() const {return height_ == width_;}
+
+    // tile_side x tile_side row-major tile
+    T*       tile(size_type ti, size_type tj)       {return data_.data() + tile_pos_[ti * tiles_width_ + tj] * tile_area;}
+    const T* tile(size_type ti, size_type tj) const {return data_.data() + tile_pos_[ti * tiles_width_ + tj] * tile_area;}
+
+    // (ti, tj) of tile at position pos in storage
+    std::pair<size_type, size_type> tile_index(size_type pos) const
+    {
+        return {tile_at_[pos] / tiles_width_, tile_at_[pos] % tiles_width_};
+    }
+
+    // part of row i in tile column tj
+    T*       tile_row(size_type i, size_type tj)       {return tile(i / tile_side, tj) + (i % tile_side) * tile_side;}
+    const T* tile_row(size_type i, size_type tj) const {return tile(i / tile_side, tj) + (i % tile_side) * tile_side;}
+
+    reference to(size_type i, size_type j) noexcept
+    {
+        return tile_row(i, j / tile_side)[j % tile_side];
+    }
+
+    const_reference to(size_type i, size_type j) const noexcept
+    {
+        return tile_row(i, j / tile_side)[j % tile_side];
+    }
+
+    reference at(size_type i, size_type j)
+    {
+        if (i >= height_ || j >= width_)
+            throw std::out_of_range{"try to get element of TiledMatrix with index out of range"};
+        return to(i, j);
+    }
+
+    const_reference at(size_type i, size_type j) const
+    {
+        if (i >= height_ || j >= width_)
+            throw std::out_of_range{"try to get element of TiledMatrix with index out of range"};
+        return to(i, j);
+    }
+//--------------------------------=| Acces operators end |=---------------------------------------------
+
+//--------------------------------=| Swap rows and columns start |=-------------------------------------
+    void swap_row(size_type ind1, size_type ind2)
+    {
+        if (ind1 >= height_ || ind2 >= height_)
+            throw std::out_of_range{"try to swap rows with indexis out of range"};
+
+        for (size_type tj = 0; tj < tiles_width_; tj++)
+            std::swap_ranges(tile_row(ind1, tj), tile_row(ind1, tj) + tile_side, tile_row(ind2, tj));
+    }
+
+    // tile by tile: one cache line per row as in row-major matrix, but lines of every tile are
+    // in one contiguous tile, padding rows hold zeros in both columns and stay zero
+    void swap_col(size_type ind1, size_type ind2)
+    {
+        if (ind1 >= width_ || ind2 >= width_)
+            throw std::out_of_range{"try to swap columns with indexis out of range"};
+
+        const size_type tj1 = ind1 / tile_side, tj2 = ind2 / tile_side;
+        const size_type j1 = ind1 % tile_side, j2 = ind2 % tile_side;
+        for (size_type ti = 0; ti < tiles_height_; ti++)
+        {
+            T* tile1 = tile(ti, tj1) + j1;
+            T* tile2 = tile(ti, tj2) + j2;
+            for (size_type r = 0; r < tile_side; r++)
+                std::swap(tile1[r * tile_side], tile2[r * tile_side]);
+        }
+    }
+//--------------------------------=| Swap rows and columns end |=---------------------------------------
+
+    // tiles are transposed in place of mirrored tiles, chunks of storage go in parallel
+    TiledMatrix transpos() const
+    {
+        MATRIX_PROFILE_SCOPE("tiled_transpos");
+        TiledMatrix res (width_, height_);
+        detail::parallel_for(0, res.tiles_num(), [&](size_type first, size_type last)
+        {
+            for (size_type pos = first; pos < last; pos++)
+            {
+                auto [ti, tj] = res.tile_index(pos);
+                const T* src = tile(tj, ti);
+                T* dst = res.tile(ti, tj);
+                for (size_type r = 0; r < tile_side; r++)
+                    for (size_type c = 0; c < tile_side; c++)
+                        dst[r * tile_side + c] = src[c * tile_side + r];
+            }
+        }, detail::rows_per_chunk(tile_area));
+        return res;
+    }
+
+    friend bool operator==(const TiledMatrix& lhs, const TiledMatrix& rhs) = default;
+};
+
+namespace detail
+{
+
+// c += a * b (or c -= a * b) for row-major square tiles of side Side,
+// row of c is accumulated in local array, which compiler keeps in vector registers
+template<std::size_t Side, bool IsSub = false, typename T>
+void tile_multiply_add(const T* a, const T* b, T* c)
+{
+    for (std::size_t i = 0; i < Side; i++)
+    {
+        T acc[Side];
+        std::copy(c + i * Side, c + (i + 1) * Side, acc);
+        for (std::size_t k = 0; k < Side; k++)
+        {
+            const T a_ik = IsSub ? -a[i * Side + k] : a[i * Side + k];
+            const T* b_row = b + k * Side;
+            for (std::size_t j = 0; j < Side; j++)
+                acc[j] += a_ik * b_row[j];
+        }
+        std::copy(acc, acc + Side, c + i * Side);
+    }
+}
+
+} // namespace detail
+
+template<typename T = int, class Layout = MortonTiles<>>
+TiledMatrix<T, Layout> transpos(const TiledMatrix<T, Layout>& mat)
+{
+    return mat.transpos();
+}
+
+// tiles of result go in parallel in storage order, for MortonTiles every chunk of them is compact
+// block of result, so tiles of lhs and rhs which it needs are reused from cache
+template<typename T = int, class Layout = MortonTiles<>>
+TiledMatrix<T, Layout> product(const TiledMatrix<T, Layout>& lhs, const TiledMatrix<T, Layout>& rhs)
+{
+    if (lhs.width() != rhs.height())
+        throw std::invalid_argument{"in product: lhs.width() != rhs.height()"};
+
+    using size_type = typename TiledMatrix<T, Layout>::size_type;
+    constexpr size_type side = TiledMatrix<T, Layout>::tile_side;
+
+    MATRIX_PROFILE_SCOPE("tiled_product");
+    MATRIX_PROFILE_FLOPS(2 * lhs.height() * rhs.width() * lhs.width());
+    TiledMatrix<T, Layout> res (lhs.height(), rhs.width());
+    detail::parallel_for(0, res.tiles_num(), [&](size_type first, size_type last)
+    {
+        for (size_type pos = first; pos < last; pos++)
+        {
+            auto [ti, tj] = res.tile_index(pos);
+            T* c = res.tile(ti, tj);
+            for (size_type tk = 0; tk < lhs.tiles_width(); tk++)
+                detail::tile_multiply_add<side>(lhs.tile(ti, tk), rhs.tile(tk, tj), c);
+        }
+    });
+    return res;
+}
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Blocked right-looking LU with partial pivoting on tiles: P * A = L * U.      |
+ * Panel of one tile column is factorized with pivot search down the tiles of  |
+ * that column, rows are swapped physically. Then row of tiles of U is solved  |
+ * with unit lower diagonal tile and trailing tiles are updated by tile GEMM   |
+ * in parallel. Row i of P * A is row permutation()[i] of A.                   |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+template<typename T, class Layout>
+class TiledLUDecomposition
+{
+public:
+    using matrix_type      = TiledMatrix<T, Layout>;
+    using size_type        = typename matrix_type::size_type;
+    using value_type       = T;
+    using permutation_type = std::vector<size_type>;
+
+private:
+    static constexpr size_type side = matrix_type::tile_side;
+
+    matrix_type lu_;
+    permutation_type perm_;
+    value_type sign_ {1};
+    bool is_singular_ = false;
+
+    void factorize_panel(size_type tk)
+    {
+        const size_type n = size();
+        detail::DefaultAbs<T> abs {};
+        for (size_type k = tk * side; k < std::min(n, (tk + 1) * side); k++)
+        {
+            size_type col = k % side;
+            size_type pivot = k;
+            for (size_type i = k + 1; i < n; i++)
+                if (abs(lu_.tile_row(pivot, tk)[col]) < abs(lu_.tile_row(i, tk)[col]))
+                    pivot = i;
+            if (lu_.tile_row(pivot, tk)[col] == value_type{})
+            {
+                is_singular_ = true;
+                continue;
+            }
+            if (pivot != k)
+            {
+                lu_.swap_row(k, pivot);
+                std::swap(perm_[k], perm_[pivot]);
+                sign_ = -sign_;
+            }
+
+            const T* row_k = lu_.tile_row(k, tk);
+            for (size_type i = k + 1; i < n; i++)
+            {
+                T* row_i = lu_.tile_row(i, tk);
+                row_i[col] /= row_k[col];
+                for (size_type j = col + 1; j < side; j++)
+                    detail::fused_mul_sub(row_i[j], row_i[col], row_k[j]);
+            }
+        }
+    }
+
+    // row of tiles right to diagonal: U_kj = L_kk^{-1} * A_kj
+    void solve_tile_row(size_type tk)
+    {
+        const T* diag = lu_.tile(tk, tk);
+        detail::parallel_for(tk + 1, lu_.tiles_width(), [&](size_type first, size_type last)
+        {
+            for (size_type tj = first; tj < last; tj++)
+            {
+                T* u = lu_.tile(tk, tj);
+                for (size_type r = 1; r < side; r++)
+                    for (size_type q = 0; q < r; q++)
+                        for (size_type c = 0; c < side; c++)
+                            detail::fused_mul_sub(u[r * side + c], diag[r * side + q], u[q * side + c]);
+            }
+        });
+    }
+
+    void update_trailing(size_type tk)
+    {
+        size_type rest = lu_.tiles_width() - tk - 1;
+        detail::parallel_for(0, rest * rest, [&](size_type first, size_type last)
+        {
+            for (size_type ind = first; ind < last; ind++)
+            {
+                size_type ti = tk + 1 + ind / rest, tj = tk + 1 + ind % rest;
+                detail::tile_multiply_add<side, true>(lu_.tile(ti, tk), lu_.tile(tk, tj), lu_.tile(ti, tj));
+            }
+        });
+    }
+
+public:
+    explicit TiledLUDecomposition(const matrix_type& mat)
+    :lu_ {mat}, perm_ (mat.height())
+    {
+        if (!mat.is_square())
+            throw std::invalid_argument{"try to get LU factorization of no square matrix"};
+
+        MATRIX_PROFILE_SCOPE("tiled_lu");
+        MATRIX_PROFILE_FLOPS(2 * size() * size() * size() / 3);
+        std::iota(perm_.begin(), perm_.end(), size_type{0});
+        for (size_type tk = 0; tk < lu_.tiles_width(); tk++)
+        {
+            factorize_panel(tk);
+            solve_tile_row(tk);
+            update_trailing(tk);
+        }
+    }
+
+    size_type size() const {return lu_.height();}
+
+    const permutation_type& permutation() const {return perm_;}
+
+    // sign of permutation: 1 or -1
+    value_type sign() const {return sign_;}
+
+    // element (i, j) of packed L and U in permuted order
+    const value_type& packed(size_type i, size_type j) const {return lu_.to(i, j);}
+
+    const matrix_type& packed() const {return lu_;}
+
+    bool is_singular() const {return is_singular_;}
+
+    value_type determinant() const
+    {
+        value_type res = sign_;
+        for (size_type i = 0; i < size(); i++)
+            res *= lu_.to(i, i);
+        return res;
+    }
+
+    // solve A * x = rhs
+    DenseVector<T> solve(const DenseVector<T>& rhs) const
+    {
+        if (rhs.size() != size())
+            throw std::invalid_argument{"in solve: rhs.size() != size of factorized matrix"};
+        if (is_singular())
+            throw std::invalid_argument{"try to solve system with singular matrix"};
+
+        MATRIX_PROFILE_SCOPE("tiled_lu_solve");
+        DenseVector<T> res (size());
+        for (size_type i = 0; i < size(); i++)
+            res[i] = rhs[perm_[i]];
+        for (size_type i = 0; i < size(); i++)
+            for (size_type k = 0; k < i; k++)
+                detail::fused_mul_sub(res[i], lu_.to(i, k), res[k]);
+        for (size_type i = size() - 1; static_cast<long long>(i) >= 0; i--)
+        {
+            for (size_type k = i + 1; k < size(); k++)
+                detail::fused_mul_sub(res[i], lu_.to(i, k), res[k]);
+            res[i] /= lu_.to(i, i);
+        }
+        MATRIX_PROFILE_FLOPS(2 * size() * size());
+        return res;
+    }
+};
+
+template<typename T = int, class Layout = MortonTiles<>>
+TiledLUDecomposition<T, Layout> lu(const TiledMatrix<T, Layout>& mat)
+{
+    return TiledLUDecomposition<T, Layout>{mat};
+}
+
+} // namespace Matrix
@@ -0,0 +1,71 @@
+#pragma once
+#include "matrix_lu.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Low rank updates: results for A + U * V^T (U and V are n x k) from results   |
+ * already known for A in O(n^2 * k) instead of O(n^3).                          |
+ * For LU factorization see LUDecomposition::rank_one_update() and rank_update().|
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+namespace detail
+{
+
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+void check_low_rank_args(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& inv,
+                         const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& u,
+                         const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& v)
+{
+    if (!inv.is_square())
+        throw std::invalid_argument{"low rank update of inverse for no square matrix"};
+    if (u.height() != inv.height() || v.height() != inv.height() || u.width() != v.width())
+        throw std::invalid_argument{"in low rank update: U and V have to be n x k"};
+}
+
+// capacitance matrix I + V^T * A^-1 * U (k x k)
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+MatrixArithmetic<T, IsDivArithm, Cmp, Abs> capacitance(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& v,
+                                                       const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& inv_u)
+{
+    auto res = product(v.transpos(), inv_u);
+    for (std::size_t i = 0; i < res.height(); i++)
+        res.to(i, i) += T{1};
+    return res;
+}
+
+} // namespace detail
+
+// (A + U * V^T)^-1 by Sherman-Morrison-Woodbury formula from inv = A^-1
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+MatrixArithmetic<T, IsDivArithm, Cmp, Abs> inverse_update(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& inv,
+                                                          const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& u,
+                                                          const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& v)
+{
+    detail::check_low_rank_args(inv, u, v);
+
+    MATRIX_PROFILE_SCOPE("inverse_update");
+    auto inv_u = product(inv, u);                // n x k
+    auto vt_inv = product(v.transpos(), inv);    // k x n
+    auto cap_lu = lu(detail::capacitance(v, inv_u));
+    if (cap_lu.is_singular())
+        throw std::invalid_argument{"low rank update makes matrix singular"};
+
+    return inv - product(inv_u, cap_lu.solve(vt_inv));
+}
+
+// det(A + U * V^T) = det(I + V^T * A^-1 * U) * det(A) by matrix determinant lemma
+template<typename T, bool IsDivArithm, class Cmp, class Abs>
+T determinant_update(const T& det, const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& inv,
+                     const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& u,
+                     const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& v)
+{
+    detail::check_low_rank_args(inv, u, v);
+
+    MATRIX_PROFILE_SCOPE("determinant_update");
+    return detail::capacitance(v, product(inv, u)).determinant() * det;
+}
+
+} // namespace Matrix
@@ -0,0 +1,294 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <initializer_list>
+#include <ostream>
+#include <stdexcept>
+#include "matrix_arithmetic.hpp"
+#include "matrix_parallel.hpp"
+#include "matrix_storage.hpp"
+
+/*
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ * Dense vector: one contiguous aligned buffer instead of column of one element |
+ * rows. Converts from and to column and row MatrixArithmetic. Kernels:         |
+ * gemv (A * x), gemv_transposed (A^T * x), axpy (y += alpha * x), dot, norm.   |
+ * Kernels over big data are split between threads, inner loops go by          |
+ * independent accumulators to be vectorized.                                   |
+ *++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ */
+
+namespace Matrix
+{
+
+template<typename T = int>
+class DenseVector
+{
+public:
+    using size_type       = std::size_t;
+    using value_type      = T;
+    using reference       = T&;
+    using const_reference = const T&;
+    using iterator        = typename detail::aligned_vector<T>::iterator;
+    using const_iterator  = typename detail::aligned_vector<T>::const_iterator;
+
+private:
+    detail::aligned_vector<T> data_ {};
+
+public:
+//--------------------------------=| Ctors start |=-----------------------------------------------------
+    DenseVector() = default;
+
+    explicit DenseVector(size_type sz, const_reference val = value_type{})
+    :data_ (sz, val)
+    {
+        MATRIX_PROFILE_ALLOC(sz * sizeof(value_type));
+    }
+
+    DenseVector(std::initializer_list<value_type> list)
+    :data_ (list.begin(), list.end())
+    {
+        MATRIX_PROFILE_ALLOC(list.size() * sizeof(value_type));
+    }
+
+    // from column or row matrix
+    template<bool IsDivArithm, class Cmp, class Abs>
+    explicit DenseVector(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat)
+    {
+        if (!mat.is_column() && !mat.is_row())
+            throw std::invalid_argument{"try to make DenseVector from matrix that is not column or row"};
+        data_.reserve(mat.height() * mat.width());
+        for (const auto& row: mat)
+            data_.insert(data_.end(), row.begin(), row.end());
+    }
+//--------------------------------=| Ctors end |=-------------------------------------------------------
+
+//--------------------------------=| Conversions start |=-----------------------------------------------
+    template<bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> to_column() const
+    {
+        MatrixArithmetic<T, IsDivArithm, Cmp, Abs> res (size(), 1);
+        for (size_type i = 0; i < size(); i++)
+            res.to(i, 0) = data_[i];
+        return res;
+    }
+
+    template<bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+    MatrixArithmetic<T, IsDivArithm, Cmp, Abs> to_row() const
+    {
+        return MatrixArithmetic<T, IsDivArithm, Cmp, Abs>(1, size(), data_.begin(), data_.end());
+    }
+//--------------------------------=| Conversions end |=-------------------------------------------------
+
+//--------------------------------=| Acces operators start |=-------------------------------------------
+    size_type size() const {return data_.size();}
+    bool is_empty() const {return data_.empty();}
+
+    reference       operator[](size_type ind)       {return data_[ind];}
+    const_reference operator[](size_type ind) const {return data_[ind];}
+
+    reference       at(size_type ind)       {return data_.at(ind);}
+    const_reference at(size_type ind) const {return data_.at(ind);}
+
+    T*       data()       {return data_.data();}
+    const T* data() const {return data_.data();}
+
+    iterator begin() {return data_.begin();}
+    iterator end()   {return data_.end();}
+
+    const_iterator begin() const {return data_.cbegin();}
+    const_iterator end()   const {return data_.cend();}
+//--------------------------------=| Acces operators end |=---------------------------------------------
+
+//--------------------------------=| Basic arithmetic start |=------------------------------------------
+    DenseVector& operator+=(const DenseVector& rhs)
+    {
+        return axpy(value_type{1}, rhs);
+    }
+
+    DenseVector& operator-=(const DenseVector& rhs)
+    {
+        return axpy(value_type{-1}, rhs);
+    }
+
+    DenseVector& operator*=(const_reference rhs)
+    {
+        MATRIX_PROFILE_SCOPE("DenseVector::operator*=");
+        MATRIX_PROFILE_FLOPS(size());
+        detail::parallel_for(0, size(), [&](size_type first, size_type last)
+        {
+            T* y = data_.data();
+            for (size_type i = first; i < last; i++)
+                y[i] *= rhs;
+        }, detail::rows_per_chunk(1));
+        return *this;
+    }
+
+    // this += alpha * x
+    DenseVector& axpy(const_reference alpha, const DenseVector& x)
+    {
+        if (size() != x.size())
+            throw std::invalid_argument{"in axpy: vectors of different sizes"};
+
+        MATRIX_PROFILE_SCOPE("axpy");
+        MATRIX_PROFILE_FLOPS(2 * size());
+        detail::parallel_for(0, size(), [&](size_type first, size_type last)
+        {
+            T* y = data_.data();
+            const T* x_data = x.data();
+            for (size_type i = first; i < last; i++)
+                y[i] += alpha * x_data[i];
+        }, detail::rows_per_chunk(1));
+        return *this;
+    }
+//--------------------------------=| Basic arithmetic end |=--------------------------------------------
+
+    friend bool operator==(const DenseVector& lhs, const DenseVector& rhs) = default;
+};
+
+template<typename T = int>
+DenseVector<T> operator+(DenseVector<T> lhs, const DenseVector<T>& rhs) {return lhs += rhs;}
+
+template<typename T = int>
+DenseVector<T> operator-(DenseVector<T> lhs, const DenseVector<T>& rhs) {return lhs -= rhs;}
+
+template<typename T = int>
+DenseVector<T> operator*(DenseVector<T> lhs, const T& rhs) {return lhs *= rhs;}
+
+template<typename T = int>
+DenseVector<T> operator*(const T& lhs, DenseVector<T> rhs) {return rhs *= lhs;}
+
+template<typename T = int>
+std::ostream& operator<<(std::ostream& os, const DenseVector<T>& vec)
+{
+    os << '{';
+    for (std::size_t i = 0; i < vec.size(); i++)
+        os << ((i == 0) ? "" : " ") << vec[i];
+    return os << '}';
+}
+
+//--------------------------------=| Kernels start |=---------------------------------------------------
+// y = alpha * x + y
+template<typename T = int>
+void axpy(const T& alpha, const DenseVector<T>& x, DenseVector<T>& y)
+{
+    y.axpy(alpha, x);
+}
+
+// partial dot products of chunks are summed by the calling thread
+template<typename T = int>
+T dot(const DenseVector<T>& lhs, const DenseVector<T>& rhs)
+{
+    if (lhs.size() != rhs.size())
+        throw std::invalid_argument{"in dot: vectors of different sizes"};
+
+    MATRIX_PROFILE_SCOPE("dot");
+    MATRIX_PROFILE_FLOPS(2 * lhs.size());
+    std::size_t chunk = detail::rows_per_chunk(1);
+    std::vector<T> partial ((lhs.size() + chunk - 1) / chunk);
+    detail::parallel_for(0, partial.size(), [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t c = first; c < last; c++)
+        {
+            std::size_t begin = c * chunk, len = std::min(chunk, lhs.size() - begin);
+            partial[c] = detail::dot_kernel(lhs.data() + begin, rhs.data() + begin, len);
+        }
+    });
+
+    T res {};
+    for (const auto& part: partial)
+        res += part;
+    return res;
+}
+
+// euclidean norm in one pass: every chunk is scaled by its own max element while it is in cache,
+// then sums of squares of chunks are rescaled to common max by the calling thread in fixed order
+template<std::floating_point T>
+T norm(const DenseVector<T>& vec)
+{
+    MATRIX_PROFILE_SCOPE("norm");
+    MATRIX_PROFILE_FLOPS(3 * vec.size());
+    struct Partial
+    {
+        T scale;
+        T ssq;
+    };
+
+    std::size_t chunk = detail::rows_per_chunk(1);
+    std::vector<Partial> partial ((vec.size() + chunk - 1) / chunk);
+    detail::parallel_for(0, partial.size(), [&](std::size_t first, std::size_t last)
+    {
+        constexpr std::size_t lanes_num = 8;
+        for (std::size_t c = first; c < last; c++)
+        {
+            const T* data = vec.data() + c * chunk;
+            std::size_t len = std::min(chunk, vec.size() - c * chunk);
+            T scale {};
+            for (std::size_t k = 0; k < len; k++)
+                scale = std::max(scale, std::abs(data[k]));
+
+            T inv = (scale == T{}) ? T{} : T{1} / scale;
+            T lanes[lanes_num] {};
+            std::size_t k = 0;
+            for (; k + lanes_num <= len; k += lanes_num)
+                for (std::size_t l = 0; l < lanes_num; l++)
+                    lanes[l] += (data[k + l] * inv) * (data[k + l] * inv);
+            for (; k < len; k++)
+                lanes[0] += (data[k] * inv) * (data[k] * inv);
+            T ssq {};
+            for (auto lane: lanes)
+                ssq += lane;
+            partial[c] = {scale, ssq};
+        }
+    });
+
+    T scale {};
+    for (const auto& part: partial)
+        scale = std::max(scale, part.scale);
+    if (!std::isfinite(scale))
+        return scale;
+
+    T inv = (scale == T{}) ? T{} : T{1} / scale;
+    T ssq {};
+    for (const auto& part: partial)
+        ssq += part.ssq * (part.scale * inv) * (part.scale * inv);
+    return scale * std::sqrt(ssq);
+}
+
+// y = mat * x
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+DenseVector<T> gemv(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat, const DenseVector<T>& x)
+{
+    if (mat.width() != x.size())
+        throw std::invalid_argument{"in gemv: mat.width() != x.size()"};
+
+    MATRIX_PROFILE_SCOPE("gemv");
+    MATRIX_PROFILE_FLOPS(2 * mat.height() * mat.width());
+    DenseVector<T> y (mat.height());
+    detail::gemv_kernel(mat, x.data(), y.data());
+    return y;
+}
+
+// y = mat^T * x
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+DenseVector<T> gemv_transposed(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat, const DenseVector<T>& x)
+{
+    if (mat.height() != x.size())
+        throw std::invalid_argument{"in gemv_transposed: mat.height() != x.size()"};
+
+    MATRIX_PROFILE_SCOPE("gemv_transposed");
+    MATRIX_PROFILE_FLOPS(2 * mat.height() * mat.width());
+    DenseVector<T> y (mat.width());
+    detail::gemv_transposed_kernel(mat, x.data(), y.data());
+    return y;
+}
+
+template<typename T = int, bool IsDivArithm = false, class Cmp = std::equal_to<T>, class Abs = detail::DefaultAbs<T>>
+DenseVector<T> product(const MatrixArithmetic<T, IsDivArithm, Cmp, Abs>& mat, const DenseVector<T>& x)
+{
+    return gemv(mat, x);
+}
+//--------------------------------=| Kernels end |=-----------------------------------------------------
+
+} // namespace Matrix
@@ -0,0 +1,173 @@
+#include "matrix_parallel.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Generates A = H1 * U * H2 with known determinant:
+ * U - upper triangular with random diagonal (like in testgen.py) and few small entries over it,
+ * H1, H2 - Householder reflections I - 2 * v * v^T / (v^T * v), det(H1 * H2) = 1.
+ * Reflections are orthogonal, so A is dense but has the same condition number as U,
+ * det(A) = product of diagonal of U.
+ * Element of A is U(i, j) - a(i) * v2(j) - v1(i) * w(j), vectors a and w are precomputed in O(n),
+ * so rows are built in parallel, file is written by chunks of rows.
+ */
+
+namespace
+{
+
+constexpr std::size_t upper_entries = 4;
+constexpr std::size_t chunk_rows = 256;
+
+struct Entry
+{
+    std::size_t index;
+    double coef;
+};
+
+struct UpperRow
+{
+    double diag;
+    std::vector<Entry> entries;
+};
+
+std::vector<UpperRow> make_upper(std::mt19937_64& gen, std::size_t mat_sz, int max_num)
+{
+    std::uniform_int_distribution num_dist {-max_num, max_num};
+    std::uniform_int_distribution coef_dist {-2, 2};
+    std::vector<UpperRow> res (mat_sz);
+    for (std::size_t i = 0; i < mat_sz; i++)
+    {
+        double number = num_dist(gen);
+        if (number == 0.0)
+            number = 1.0;
+        res[i].diag = number * 0.75;
+        if (i + 1 == mat_sz)
+            continue;
+        std::uniform_int_distribution<std::size_t> index_dist {i + 1, mat_sz - 1};
+        for (std::size_t k = 0; k < upper_entries; k++)
+            res[i].entries.push_back({index_dist(gen), coef_dist(gen) * 0.125});
+    }
+    return res;
+}
+
+std::vector<double> random_vector(std::mt19937_64& gen, std::size_t mat_sz)
+{
+    std::uniform_int_distribution dist {-9, 9};
+    std::vector<double> res (mat_sz);
+    for (auto& elem: res)
+        elem = dist(gen);
+    res[0] = 10.0; // not null vector
+    return res;
+}
+
+double dot(const std::vector<double>& lhs, const std::vector<double>& rhs)
+{
+    double res = 0.0;
+    for (std::size_t i = 0; i < lhs.size(); i++)
+        res += lhs[i] * rhs[i];
+    return res;
+}
+
+void append_number(std::string& str, double number)
+{
+    char buf[32];
+    auto [end, err] = std::to_chars(buf, buf + sizeof(buf), number);
+    str.append(buf, end);
+    str.push_back(' ');
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " SIZE NUM NAME [SEED]" << std::endl;
+        return 1;
+    }
+
+    std::size_t mat_sz = std::stoull(argv[1]);
+    int max_num = std::stoi(argv[2]);
+    std::string name = argv[3];
+    std::mt19937_64 gen {(argc > 4) ? std::stoull(argv[4]) : std::random_device{}()};
+
+    if (mat_sz == 0)
+    {
+        std::cerr << "SIZE has to be positive" << std::endl;
+        return 1;
+    }
+
+    auto upper = make_upper(gen, mat_sz, max_num);
+    auto v1 = random_vector(gen, mat_sz);
+    auto v2 = random_vector(gen, mat_sz);
+    double c1 = 2.0 / dot(v1, v1);
+    double c2 = 2.0 / dot(v2, v2);
+
+    // U * H2 = U - a * v2^T, a = c2 * U * v2
+    std::vector<double> a (mat_sz);
+    for (std::size_t i = 0; i < mat_sz; i++)
+    {
+        a[i] = upper[i].diag * v2[i];
+        for (const auto& entry: upper[i].entries)
+            a[i] += entry.coef * v2[entry.index];
+        a[i] *= c2;
+    }
+
+    // H1 * U * H2 = U * H2 - v1 * w^T, w^T = c1 * v1^T * U * H2
+    std::vector<double> w (mat_sz);
+    for (std::size_t i = 0; i < mat_sz; i++)
+    {
+        w[i] += v1[i] * upper[i].diag;
+        for (const auto& entry: upper[i].entries)
+            w[entry.index] += v1[i] * entry.coef;
+    }
+    double v1_a = dot(v1, a);
+    for (std::size_t j = 0; j < mat_sz; j++)
+        w[j] = c1 * (w[j] - v1_a * v2[j]);
+
+    std::ofstream mat_file {name + "_mat"};
+    mat_file << mat_sz << '\n';
+
+    std::vector<std::string> lines (chunk_rows);
+    for (std::size_t chunk_begin = 0; chunk_begin < mat_sz; chunk_begin += chunk_rows)
+    {
+        std::size_t chunk_end = std::min(mat_sz, chunk_begin + chunk_rows);
+        Matrix::detail::parallel_for(chunk_begin, chunk_end, [&](std::size_t first, std::size_t last)
+        {
+            std::vector<double> row (mat_sz);
+            for (std::size_t i = first; i < last; i++)
+            {
+                for (std::size_t j = 0; j < mat_sz; j++)
+                    row[j] = -a[i] * v2[j] - v1[i] * w[j];
+                row[i] += upper[i].diag;
+                for (const auto& entry: upper[i].entries)
+                    row[entry.index] += entry.coef;
+
+                auto& line = lines[i - chunk_begin];
+                line.clear();
+                for (auto elem: row)
+                    append_number(line, elem);
+            }
+        });
+        for (std::size_t i = chunk_begin; i < chunk_end; i++)
+            mat_file << lines[i - chunk_begin];
+    }
+    mat_file << '\n';
+
+    double det = 1.0;
+    for (const auto& row: upper)
+        det *= row.diag;
+
+    std::ofstream det_file {name + "_det"};
+    std::string det_str;
+    append_number(det_str, det);
+    det_str.pop_back();
+    det_file << det_str << '\n';
+
+    return 0;
+}
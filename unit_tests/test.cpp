@@ -4,8 +4,29 @@
 #include <vector>
 #include <set>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include <random>
 
+#include "matrix_accurate.hpp"
 #include "matrix_arithmetic.hpp"
+#include "matrix_async.hpp"
+#include "matrix_cached.hpp"
+#include "matrix_exact.hpp"
+#include "matrix_expm.hpp"
+#include "matrix_lu.hpp"
+#include "matrix_mixed.hpp"
+#include "matrix_profiler.hpp"
+#include "matrix_qr.hpp"
+#include "matrix_reduce.hpp"
+#include "matrix_spectral.hpp"
+#include "matrix_storage.hpp"
+#include "matrix_strassen.hpp"
+#include "matrix_tiled.hpp"
+#include "matrix_update.hpp"
+#include "matrix_vector.hpp"
 
 //#define PRINT
 
@@ -229,6 +250,230 @@ TEST(Methods, det_for_double)
     EXPECT_TRUE(dbl_cmp(mat7.determinant(), -0.0));
 }
 
+TEST(Methods, det_parallel)
+{
+    DblCmp dbl_cmp {};
+    std::mt19937 gen {42};
+    std::uniform_int_distribution dist {-9, 9};
+    std::vector<double> data (37 * 37);
+    for (auto& elem: data)
+        elem = static_cast<double>(dist(gen)) / 4;
+
+    MatrixArithmetic<double, true, DblCmp> mat1 (37, 37, data.begin(), data.end());
+    MatrixArithmetic<double, true, DblCmp> mat2 = {{1, 0, 34}, {23, 0, -11}, {2, 0, 2}};
+    MatrixArithmetic<double, true, DblCmp> mat3 = {{1, 12, 4.7, -0.3}, {-78, 0.8, 9.6, 87}, {-5, -0.9, 4.7, 21.8}, {0, 2, 7, 9}};
+
+    for (std::size_t n_threads: {1, 2, 3, 5})
+    {
+        EXPECT_TRUE(dbl_cmp(mat1.determinant_parallel(n_threads), mat1.determinant()));
+        EXPECT_FALSE(dbl_cmp(mat1.determinant_parallel(n_threads), 0.0));
+        EXPECT_TRUE(dbl_cmp(mat2.determinant_parallel(n_threads), 0.0));
+        EXPECT_TRUE(dbl_cmp(mat3.determinant_parallel(n_threads), -57462.22));
+    }
+    EXPECT_EQ(detail::busy_threads().load(), 0);
+
+    // nested calls get only threads left in budget, result doesn't depend on their number
+    detail::parallel_for(0, 4, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t n_threads = first + 2; n_threads < last + 2; n_threads++)
+            EXPECT_DOUBLE_EQ(mat1.determinant_parallel(n_threads), mat1.determinant_parallel(1));
+    });
+    EXPECT_EQ(detail::busy_threads().load(), 0);
+}
+
+TEST(Methods, lu)
+{
+    DblCmp dbl_cmp {};
+    MatrixArithmetic<double, true, DblCmp> mat = {{1, 12, 4.7, -0.3}, {-78, 0.8, 9.6, 87}, {-5, -0.9, 4.7, 21.8}, {0, 2, 7, 9}};
+
+    auto mat_lu = lu(mat);
+    const auto& perm = mat_lu.permutation();
+    EXPECT_TRUE(std::is_permutation(perm.begin(), perm.end(), std::vector<std::size_t>{0, 1, 2, 3}.begin()));
+    EXPECT_EQ(perm[0], 1);
+
+    MatrixArithmetic<double, true, DblCmp> permuted (4, 4);
+    for (std::size_t i = 0; i < 4; i++)
+        for (std::size_t j = 0; j < 4; j++)
+            permuted.to(i, j) = mat.to(perm[i], j);
+
+    EXPECT_EQ(product(mat_lu.lower(), mat_lu.upper()), permuted);
+    EXPECT_TRUE(dbl_cmp(mat_lu.determinant(), -57462.22));
+    EXPECT_FALSE(mat_lu.is_singular());
+    EXPECT_TRUE(lu(MatrixArithmetic<double, true, DblCmp>{{1, 0, 34}, {23, 0, -11}, {2, 0, 2}}).is_singular());
+}
+
+TEST(Methods, solve)
+{
+    MatrixArithmetic<double, true, DblCmp> mat = {{1, 12, 4.7, -0.3}, {-78, 0.8, 9.6, 87}, {-5, -0.9, 4.7, 21.8}, {0, 2, 7, 9}};
+    MatrixArithmetic<double, true, DblCmp> rhs = {{1, 2}, {-3, 0}, {0.5, 7}, {2, -1}};
+
+    auto res = solve(mat, rhs);
+    EXPECT_EQ(product(mat, res), rhs);
+    EXPECT_EQ(lu(mat).inverse(), mat.inverse());
+    EXPECT_THROW(solve(MatrixArithmetic<double, true, DblCmp>{{1, 2}, {2, 4}}, MatrixArithmetic<double, true, DblCmp>{1, 1}),
+                 std::invalid_argument);
+}
+
+TEST(Methods, mixed_solve)
+{
+    MatrixArithmetic<double, true, DblCmp> mat = {{1, 12, 4.7, -0.3}, {-78, 0.8, 9.6, 87}, {-5, -0.9, 4.7, 21.8}, {0, 2, 7, 9}};
+    MatrixArithmetic<double, true, DblCmp> rhs = {{1, 2}, {-3, 0}, {0.5, 7}, {2, -1}};
+
+    auto res = mixed_solve(mat, rhs);
+    EXPECT_FALSE(res.is_fallback);
+    EXPECT_GT(res.iterations, 0);
+    EXPECT_EQ(product(mat, res.solution), rhs);
+
+    MatrixArithmetic<double, true, DblCmp> hilbert (12, 12);
+    for (std::size_t i = 0; i < 12; i++)
+        for (std::size_t j = 0; j < 12; j++)
+            hilbert.to(i, j) = 1.0 / static_cast<double>(i + j + 1);
+    EXPECT_TRUE(mixed_solve(hilbert, MatrixArithmetic<double, true, DblCmp>(12, 1, 1.0)).is_fallback);
+    auto capped = mixed_solve(hilbert, MatrixArithmetic<double, true, DblCmp>(12, 1, 1.0), {.max_iterations = 2});
+    EXPECT_TRUE(capped.is_fallback);
+    EXPECT_LE(capped.iterations, 2);
+}
+
+TEST(Methods, low_rank_update)
+{
+    DblCmp dbl_cmp {};
+    using MatrixD = MatrixArithmetic<double, true, DblCmp>;
+    MatrixD mat = {{1, 12, 4.7, -0.3}, {-78, 0.8, 9.6, 87}, {-5, -0.9, 4.7, 21.8}, {0, 2, 7, 9}};
+    MatrixD u = {{1, 0}, {-2, 1}, {0.5, 3}, {0, 1}};
+    MatrixD v = {{3, 1}, {0, 0.5}, {1, -1}, {2, 0}};
+    MatrixD u1 = {1, -2, 0.5, 0}, v1 = {3, 0, 1, 2};
+    auto updated = mat + product(u, v.transpos());
+    auto updated1 = mat + product(u1, v1.transpos());
+
+    EXPECT_EQ(inverse_update(mat.inverse(), u, v), updated.inverse());
+    EXPECT_TRUE(dbl_cmp(determinant_update(mat.determinant(), mat.inverse(), u, v), updated.determinant()));
+
+    auto mat_lu = lu(mat);
+    mat_lu.rank_one_update(u1, v1);
+    EXPECT_TRUE(dbl_cmp(mat_lu.determinant(), updated1.determinant()));
+    EXPECT_EQ(mat_lu.inverse(), updated1.inverse());
+
+    auto mat_lu_k = lu(mat);
+    mat_lu_k.rank_update(u, v);
+    EXPECT_TRUE(dbl_cmp(mat_lu_k.determinant(), updated.determinant()));
+    EXPECT_EQ(mat_lu_k.solve(MatrixD{1, 2, 3, 4}), solve(updated, MatrixD{1, 2, 3, 4}));
+}
+
+struct DblNearCmp {
+    bool operator()(double lhs, double rhs) const
+    {
+        return std::abs(lhs - rhs) <= 1e-9 * (1 + std::abs(lhs) + std::abs(rhs));
+    }
+};
+
+TEST(Methods, eigen_symmetric)
+{
+    using MatrixD = MatrixArithmetic<double, true, DblNearCmp>;
+    MatrixD mat = {{4, 1, -2, 2}, {1, 2, 0, 1}, {-2, 0, 3, -2}, {2, 1, -2, -1}};
+
+    auto eig = eigen_symmetric(mat);
+    EXPECT_TRUE(std::is_sorted(eig.values.begin(), eig.values.end()));
+    EXPECT_EQ(product(mat, eig.vectors), product(eig.vectors, MatrixD::diag(eig.values.begin(), eig.values.end())));
+    EXPECT_EQ(product(eig.vectors.transpos(), eig.vectors), MatrixD::eye(4));
+    EXPECT_TRUE(DblNearCmp{}(std::accumulate(eig.values.begin(), eig.values.end(), 0.0), 8.0));
+
+    std::mt19937 gen {11};
+    std::uniform_real_distribution dist {-1.0, 1.0};
+    MatrixD big (300, 300);
+    for (std::size_t i = 0; i < 300; i++)
+        for (std::size_t j = 0; j <= i; j++)
+            big.to(i, j) = big.to(j, i) = dist(gen);
+    auto big_eig = eigen_symmetric(big);
+    EXPECT_EQ(product(big, big_eig.vectors), product(big_eig.vectors, MatrixD::diag(big_eig.values.begin(), big_eig.values.end())));
+    EXPECT_EQ(product(big_eig.vectors.transpos(), big_eig.vectors), MatrixD::eye(300));
+
+    big.to(7, 200) += 1e-3;
+    EXPECT_THROW(eigen_symmetric(big), std::invalid_argument);
+    EXPECT_THROW(eigen_symmetric(MatrixD(2, 3)), std::invalid_argument);
+}
+
+TEST(Methods, svd)
+{
+    using MatrixD = MatrixArithmetic<double, true, DblNearCmp>;
+    MatrixD tall = {{1, 2, 0}, {-3, 1, 4}, {2, 2, 2}, {0, -1, 5}, {7, 0, 1}};
+
+    for (const auto& mat: {tall, tall.transpos()})
+    {
+        auto res = svd(mat);
+        auto rank = std::min(mat.height(), mat.width());
+        EXPECT_EQ(res.singular_values.size(), rank);
+        EXPECT_TRUE(std::is_sorted(res.singular_values.rbegin(), res.singular_values.rend()));
+        auto sigma = MatrixD::diag(res.singular_values.begin(), res.singular_values.end());
+        EXPECT_EQ(product(product(res.u, sigma), res.v.transpos()), mat);
+        EXPECT_EQ(product(res.u.transpos(), res.u), MatrixD::eye(rank));
+        EXPECT_EQ(product(res.v.transpos(), res.v), MatrixD::eye(rank));
+    }
+
+    MatrixD deficient = {{1, 2, 3, 0}, {2, 4, 6, 0}, {0, 1, 1, 0}, {1, 0, 1, 0}, {3, 1, 4, 0}};
+    for (const auto& mat: {deficient, MatrixD(4, 3)})
+    {
+        auto res = svd(mat);
+        auto rank = std::min(mat.height(), mat.width());
+        auto sigma = MatrixD::diag(res.singular_values.begin(), res.singular_values.end());
+        EXPECT_EQ(product(product(res.u, sigma), res.v.transpos()), mat);
+        EXPECT_EQ(product(res.u.transpos(), res.u), MatrixD::eye(rank));
+        EXPECT_EQ(product(res.v.transpos(), res.v), MatrixD::eye(rank));
+    }
+
+    // several panels of bidiagonalization, rank 40
+    std::mt19937 gen {13};
+    std::uniform_real_distribution dist {-1.0, 1.0};
+    MatrixD lhs (170, 40), rhs (40, 110);
+    for (auto* mat: {&lhs, &rhs})
+        for (auto& row: *mat)
+            for (auto& elem: row)
+                elem = dist(gen);
+    auto big = product(lhs, rhs);
+    for (const auto& mat: {big, big.transpos()})
+    {
+        auto res = svd(mat);
+        EXPECT_TRUE(std::is_sorted(res.singular_values.rbegin(), res.singular_values.rend()));
+        EXPECT_LT(res.singular_values[40], 1e-10 * res.singular_values[0]);
+        auto sigma = MatrixD::diag(res.singular_values.begin(), res.singular_values.end());
+        EXPECT_EQ(product(product(res.u, sigma), res.v.transpos()), mat);
+        EXPECT_EQ(product(res.u.transpos(), res.u), MatrixD::eye(110));
+        EXPECT_EQ(product(res.v.transpos(), res.v), MatrixD::eye(110));
+    }
+}
+
+TEST(Methods, qr_and_least_squares)
+{
+    using MatrixD = MatrixArithmetic<double, true, DblNearCmp>;
+    std::mt19937 gen {7};
+    std::uniform_real_distribution dist {-1.0, 1.0};
+    std::vector<double> data (90 * 5);
+    for (auto& elem: data)
+        elem = dist(gen);
+    MatrixD mat (90, 5, data.begin(), data.end());
+    MatrixD rhs (90, 2);
+    for (std::size_t i = 0; i < 90; i++)
+        rhs.to(i, 0) = dist(gen), rhs.to(i, 1) = i % 7;
+
+    auto mat_qr = QRDecomposition<double, true, DblNearCmp, detail::DefaultAbs<double>>{mat, 2};
+    EXPECT_EQ(product(mat_qr.q(), mat_qr.r()), mat);
+    EXPECT_EQ(product(mat_qr.q().transpos(), mat_qr.q()), MatrixD::eye(5));
+
+    auto normal = solve(product(mat.transpos(), mat), product(mat.transpos(), rhs));
+    EXPECT_EQ(least_squares(mat, rhs), normal);
+    EXPECT_EQ(least_squares(mat, rhs, 3), normal);
+    EXPECT_EQ(least_squares(mat, product(mat, normal), 4), normal);
+    EXPECT_THROW(least_squares(mat.transpos(), MatrixD(5, 1)), std::invalid_argument);
+    EXPECT_THROW(qr(mat.transpos()), std::invalid_argument);
+
+    std::vector<double> wide_data (150 * 100);
+    for (auto& elem: wide_data)
+        elem = dist(gen);
+    MatrixD wide (150, 100, wide_data.begin(), wide_data.end());
+    auto wide_qr = qr(wide);
+    EXPECT_EQ(product(wide_qr.q(), wide_qr.r()), wide);
+    EXPECT_EQ(product(wide_qr.q().transpos(), wide_qr.q()), MatrixD::eye(100));
+}
+
 TEST(Methods, inverse)
 {
     MatrixArithmetic<double, true, DblCmp> mat1 = {{1, 12, 3}, {23, 56.8, 78}, {43, 32, 7}};
@@ -389,6 +634,661 @@ TEST(Methods, product)
     EXPECT_EQ(product(MatrixArithmetic{-4}, mat2), (-4) * mat2);
 }
 
+TEST(Methods, product_strassen)
+{
+    std::vector<int> data1 (67 * 45), data2 (45 * 38);
+    for (std::size_t i = 0; i < data1.size(); i++)
+        data1[i] = static_cast<int>(i * 7 % 19) - 9;
+    for (std::size_t i = 0; i < data2.size(); i++)
+        data2[i] = static_cast<int>(i * 5 % 23) - 11;
+
+    MatrixArithmetic mat1 (67, 45, data1.begin(), data1.end());
+    MatrixArithmetic mat2 (45, 38, data2.begin(), data2.end());
+
+    EXPECT_EQ(product_strassen(mat1, mat2, {.cutoff = 4, .parallel_depth = 1}), product(mat1, mat2));
+    EXPECT_EQ(product_strassen(mat1, mat2, {.cutoff = 16}), product(mat1, mat2));
+    EXPECT_EQ(product_strassen(mat1, mat2), product(mat1, mat2));
+    EXPECT_EQ(product_strassen(MatrixArithmetic{3}, mat2), 3 * mat2);
+
+    StrassenProduct<int> strassen {{.cutoff = 8, .parallel_depth = 5}};
+    MatrixArithmetic<int> res;
+    strassen(mat1, mat2, res);
+    EXPECT_EQ(res, product(mat1, mat2));
+    strassen(transpos(mat2), transpos(mat1), res);
+    EXPECT_EQ(res, transpos(product(mat1, mat2)));
+    EXPECT_EQ(strassen(mat1, mat2), product(mat1, mat2));
+}
+
+TEST(Methods, cached)
+{
+    DblCmp dbl_cmp {};
+    CachedMatrix<double, true, DblCmp> mat = {{1, 12, 3}, {23, 56.8, 78}, {43, 32, 7}};
+    MatrixArithmetic<double, true, DblCmp> origin {mat};
+
+    auto version = mat.version();
+    EXPECT_TRUE(dbl_cmp(mat.determinant(), 31098.4));
+    EXPECT_EQ(mat.inverse(), origin.inverse());
+    const auto& mat_lu = mat.lu();
+    EXPECT_EQ(&mat_lu, &mat.lu());
+    EXPECT_EQ(mat.version(), version);
+
+    mat[0][0] = 2;
+    EXPECT_NE(mat.version(), version);
+    origin.to(0, 0) = 2;
+    EXPECT_TRUE(dbl_cmp(mat.determinant(), origin.determinant()));
+    EXPECT_EQ(mat.inverse(), origin.inverse());
+
+    mat.swap_row(0, 1);
+    EXPECT_TRUE(dbl_cmp(mat.determinant(), -origin.determinant()));
+    mat *= 2;
+    EXPECT_TRUE(dbl_cmp(mat.determinant(), -8 * origin.determinant()));
+
+    CachedMatrix<int> int_mat = {{12, -3, 5}, {7, 8, 9}, {4, -7, 8}};
+    EXPECT_EQ(int_mat.determinant(), 1179);
+    int_mat.to(0, 0) = 0;
+    EXPECT_EQ(int_mat.determinant(), MatrixArithmetic<int>(int_mat).determinant());
+
+    auto& held_row = int_mat[1];
+    auto old_det = int_mat.determinant();
+    held_row[1] = 0;
+    EXPECT_EQ(int_mat.determinant(), old_det);
+    int_mat.invalidate();
+    EXPECT_EQ(int_mat.determinant(), MatrixArithmetic<int>(int_mat).determinant());
+}
+
+TEST(Methods, accurate_summation)
+{
+    using MatrixF = MatrixArithmetic<float, true>;
+    constexpr std::size_t len = 1 << 16;
+    const float big = 1 << 24; // big + 1 == big in float
+
+    MatrixF lhs (2, len + 1, 1.0f), rhs (len + 1, 2, 1.0f);
+    lhs.to(0, 0) = big;
+    lhs.to(1, 0) = -big;
+    rhs.to(0, 1) = 0.0f;
+
+    auto exact = product(lhs, rhs, Summation::compensated);
+    EXPECT_EQ(exact.to(0, 0), big + len);
+    EXPECT_EQ(exact.to(1, 0), -big + len);
+    EXPECT_EQ(exact.to(0, 1), len);
+
+    auto pairwise = product(lhs, rhs, Summation::pairwise);
+    EXPECT_LE(std::abs(pairwise.to(0, 0) - (big + len)), 16.0f);
+    auto naive = product(lhs, rhs);
+    EXPECT_GT(std::abs(naive.to(0, 0) - (big + len)), len / 2);
+    EXPECT_EQ(product(lhs, rhs, Summation::naive), naive);
+
+    EXPECT_EQ(sum(lhs, Summation::compensated), 2.0f * len);
+    EXPECT_EQ(trace(exact, Summation::compensated), big + 2.0f * len);
+    EXPECT_FLOAT_EQ(frobenius_norm(MatrixF{{3, 0}, {0, 4}}, Summation::pairwise), 5.0f);
+    EXPECT_EQ(sum(lhs, Summation::naive), sum(lhs));
+    EXPECT_LE(std::abs(sum(lhs, Summation::pairwise) - 2.0f * len), 16.0f);
+    auto accurate = reduce(lhs, {.sum = true, .frobenius = true, .row_sums = true, .summation = Summation::compensated});
+    EXPECT_EQ(accurate.sum, 2.0f * len);
+    EXPECT_EQ(accurate.row_sums[0], big + len);
+    EXPECT_EQ(accurate.sum_of_squares, 2 * (big * big + len));
+    EXPECT_THROW(product(lhs, lhs, Summation::compensated), std::invalid_argument);
+}
+
+TEST(Methods, big_elementwise)
+{
+    MatrixArithmetic<double> ones (700, 500, 1.5), mat (700, 500);
+    for (std::size_t i = 0; i < mat.height(); i++)
+        for (std::size_t j = 0; j < mat.width(); j++)
+            mat.to(i, j) = i * 1000.0 + j;
+
+    auto res = ones;
+    res += mat;
+    res -= ones;
+    res *= 4;
+    res /= 2;
+    EXPECT_EQ(res, 2.0 * mat);
+    EXPECT_EQ(-res, -2.0 * mat);
+
+    auto transposed = mat.transpos();
+    EXPECT_EQ(transposed.to(499, 699), mat.to(699, 499));
+    EXPECT_EQ(transposed.transpos(), mat);
+
+    ThreadPool pool {2, true};
+    std::atomic<int> counter = 0;
+    for (int i = 0; i < 10; i++)
+        pool.submit([&]{counter++;});
+    while (counter != 10)
+        std::this_thread::yield();
+}
+
+TEST(Storage, aligned_buffers)
+{
+    detail::aligned_vector<double> small (3), huge ((std::size_t{4} << 20) / sizeof(double));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(small.data()) % detail::cache_line_size, 0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(huge.data()) % detail::huge_page_size, 0);
+
+    EXPECT_EQ(detail::padded_stride<double>(3), 8);
+    EXPECT_EQ(detail::padded_stride<double>(16), 16);
+    EXPECT_EQ(detail::padded_stride<double>(512), 520);
+    EXPECT_EQ(detail::padded_stride<float>(1000), 1008);
+}
+
+TEST(Storage, allocation_policy)
+{
+    using MatrixD = MatrixArithmetic<double, true>;
+    auto address = [](const auto& row) {return reinterpret_cast<std::uintptr_t>(row.data());};
+
+    std::mt19937 gen {5};
+    std::uniform_real_distribution dist {-1.0, 1.0};
+    MatrixD plain (300, 300);
+    for (auto& row: plain)
+        for (auto& elem: row)
+            elem = dist(gen);
+
+    for (AllocationPolicy policy: {AllocationPolicy{.is_contiguous = true}, AllocationPolicy{.huge_pages = true}})
+    {
+        MatrixD mat (300, 300, policy);
+        for (std::size_t i = 0; i < mat.height(); i++)
+            mat[i] = plain[i];
+        EXPECT_EQ(address(mat[0]) % (policy.huge_pages ? detail::huge_page_size : detail::cache_line_size), 0);
+        EXPECT_EQ(address(mat[1]) - address(mat[0]), detail::padded_stride<double>(300) * sizeof(double));
+
+        auto prod = product(mat, plain);
+        EXPECT_EQ(prod, product(plain, plain));
+        EXPECT_TRUE(prod.allocation().uses_block());
+        auto mat_lu = lu(mat);
+        EXPECT_EQ(mat_lu.solve(plain), lu(plain).solve(plain));
+        EXPECT_EQ(mat_lu.solve(plain).allocation().huge_pages, policy.huge_pages);
+
+        MatrixD copy {mat};
+        EXPECT_EQ(copy, plain);
+        EXPECT_NE(address(copy[0]), address(mat[0]));
+        copy.swap_row(0, 299);
+        copy.swap_row(0, 299);
+        copy = MatrixD(2, 2);
+        mat = plain;
+        EXPECT_FALSE(mat.allocation().uses_block());
+        EXPECT_EQ(mat, plain);
+    }
+}
+
+TEST(Exact, big_int)
+{
+    BigInt factorial {1};
+    for (int i = 2; i <= 30; i++)
+        factorial *= i;
+    EXPECT_EQ(factorial.to_string(), "265252859812191058636308480000000");
+    EXPECT_EQ(factorial, BigInt{"265252859812191058636308480000000"});
+    EXPECT_EQ(factorial / BigInt{"-8222838654177922817725562880000000"} * BigInt{-31}, 0);
+    EXPECT_EQ(factorial / (factorial / 30), 30);
+
+    BigInt big {"-123456789012345678901234567890"};
+    EXPECT_EQ(big / 1000000007, BigInt{"-123456788148148161864"});
+    EXPECT_EQ(big % 1000000007, -197434842);
+    EXPECT_EQ(gcd(factorial, big), 24570);
+    EXPECT_LT(big, BigInt{std::numeric_limits<std::int64_t>::min()});
+    EXPECT_TRUE((big - big).is_small());
+
+    auto x = BigInt{std::numeric_limits<std::int64_t>::max()};
+    x.fused_mul_sub(x, -2);
+    EXPECT_EQ(x, BigInt{"27670116110564327421"});
+    x.mul_sub_div(BigInt{3}, x, BigInt{1}, BigInt{2});
+    EXPECT_EQ(x, BigInt{"27670116110564327421"});
+    EXPECT_THROW(x / 0, std::invalid_argument);
+}
+
+TEST(Exact, rational_matrix)
+{
+    std::size_t n = 6;
+    MatrixArithmetic<Rational, true> hilbert (n, n);
+    for (std::size_t i = 0; i < n; i++)
+        for (std::size_t j = 0; j < n; j++)
+            hilbert.to(i, j) = Rational{1, static_cast<int>(i + j + 1)};
+    EXPECT_EQ(hilbert.determinant(), Rational(1, BigInt{"186313420339200000"}));
+    EXPECT_EQ(hilbert.inverse().to(5, 5), 698544);
+    EXPECT_EQ(product(hilbert, hilbert.inverse()), (MatrixArithmetic<Rational, true>::eye(n)));
+
+    std::mt19937 gen {7};
+    MatrixArithmetic<Rational, true> mat (12, 12);
+    MatrixArithmetic<Rational, true> integral (12, 12);
+    MatrixArithmetic<BigInt> integers (12, 12);
+    for (std::size_t i = 0; i < mat.height(); i++)
+        for (std::size_t j = 0; j < mat.width(); j++)
+        {
+            int num = static_cast<int>(gen() % 2001) - 1000;
+            mat.to(i, j) = Rational{num, static_cast<int>(gen() % 12) + 1};
+            integral.to(i, j) = num;
+            integers.to(i, j) = num;
+        }
+    EXPECT_EQ(mat.determinant(), mat.determinant_parallel(1));
+    EXPECT_EQ(integral.determinant(), integers.determinant());
+
+    EXPECT_EQ((Rational{1, 3} + Rational{1, 6}).to_string(), "1/2");
+    EXPECT_EQ((Rational{-4, 6} * 3), -2);
+    EXPECT_THROW(Rational(1, 0), std::invalid_argument);
+}
+
+TEST(DenseVector, kernels)
+{
+    MatrixArithmetic<int> mat = {{1, 2, 3}, {4, 5, 6}};
+    DenseVector<int> x = {1, -1, 2};
+    EXPECT_EQ(gemv(mat, x), (DenseVector<int>{5, 11}));
+    EXPECT_EQ(product(mat, x), gemv(mat, x));
+    EXPECT_EQ(gemv_transposed(mat, DenseVector<int>{1, 2}), (DenseVector<int>{9, 12, 15}));
+    EXPECT_EQ(DenseVector<int>(product(mat, x.to_column())), gemv(mat, x));
+    EXPECT_EQ(product(MatrixArithmetic<int>{{1, 2}}, mat), (MatrixArithmetic<int>{{9, 12, 15}}));
+    EXPECT_EQ(x.to_row(), transpos(x.to_column()));
+    EXPECT_THROW(gemv(mat, DenseVector<int>{1, 2}), std::invalid_argument);
+    EXPECT_THROW(DenseVector<int>{mat}, std::invalid_argument);
+
+    auto y = x;
+    axpy(3, x, y);
+    EXPECT_EQ(y, 4 * x);
+    EXPECT_EQ(dot(x, y), 24);
+    EXPECT_EQ(y - x, 3 * x);
+
+    DenseVector<double> big (100000, 0.5);
+    EXPECT_DOUBLE_EQ(dot(big, big), 25000.0);
+    EXPECT_DOUBLE_EQ(norm(DenseVector<double>{3e200, 4e200}), 5e200);
+
+    // chunks of different magnitudes are rescaled to common max
+    DenseVector<double> huge (100000, 1e300);
+    EXPECT_NEAR(norm(huge) / 1e300, std::sqrt(1e5), 1e-9);
+    DenseVector<double> mixed (100000);
+    long double expected_ssq = 0;
+    for (std::size_t i = 0; i < mixed.size(); i++)
+    {
+        mixed[i] = (i < 50000) ? 1e-3 * static_cast<double>(i % 7) : 1e3 / static_cast<double>(i % 5 + 1);
+        expected_ssq += static_cast<long double>(mixed[i]) * mixed[i];
+    }
+    EXPECT_NEAR(norm(mixed), std::sqrt(static_cast<double>(expected_ssq)), 1e-8 * norm(mixed));
+    mixed *= 2.0;
+    EXPECT_NEAR(norm(mixed), 2 * std::sqrt(static_cast<double>(expected_ssq)), 1e-8 * norm(mixed));
+    EXPECT_TRUE(std::isnan(norm(DenseVector<double>{0.0, std::nan("")})));
+
+    std::mt19937 gen {3};
+    MatrixArithmetic<long long> lhs (37, 300), column (300, 1);
+    for (auto& row: lhs)
+        for (auto& elem: row)
+            elem = static_cast<long long>(gen() % 100);
+    for (auto& row: column)
+        row[0] = static_cast<long long>(gen() % 100);
+    MatrixArithmetic<long long> expected (37, 1);
+    for (std::size_t i = 0; i < lhs.height(); i++)
+        for (std::size_t k = 0; k < lhs.width(); k++)
+            expected.to(i, 0) += lhs.to(i, k) * column.to(k, 0);
+    EXPECT_EQ(product(lhs, column), expected);
+    EXPECT_EQ(product(transpos(column), transpos(lhs)), transpos(product(lhs, column)));
+}
+
+TEST(Reduce, fused_reductions)
+{
+    MatrixArithmetic<int> mat = {{1, -7, 3}, {4, 5, -6}, {9, 8, 2}};
+    auto res = reduce(mat, {.sum = true, .trace = true, .frobenius = true, .norm_1 = true, .norm_inf = true,
+                            .norm_max = true, .min = true, .max = true, .row_sums = true, .col_sums = true});
+    EXPECT_EQ(res.sum, 19);
+    EXPECT_EQ(res.trace, 8);
+    EXPECT_EQ(res.sum_of_squares, 285);
+    EXPECT_EQ(res.norm_1, 20);
+    EXPECT_EQ(res.norm_inf, 19);
+    EXPECT_EQ(res.norm_max, 9);
+    EXPECT_EQ(res.min.value, -7);
+    EXPECT_EQ(res.min.col, 1);
+    EXPECT_EQ(res.max.row, 2);
+    EXPECT_EQ(res.row_sums, (DenseVector<int>{-3, 3, 19}));
+    EXPECT_EQ(res.col_sums, (DenseVector<int>{14, 6, -1}));
+    EXPECT_EQ(reduce(mat, {.sum = true}).norm_1, 0);
+    EXPECT_THROW(trace(MatrixArithmetic<int>(2, 3)), std::invalid_argument);
+    EXPECT_THROW(argmin(MatrixArithmetic<int>{}), std::invalid_argument);
+
+    std::mt19937 gen {11};
+    MatrixArithmetic<long long> big (3000, 40);
+    for (auto& row: big)
+        for (auto& elem: row)
+            elem = static_cast<long long>(gen() % 2001) - 1000;
+    big.to(1234, 17) = 5000;
+    big.to(2345, 3) = 5000;
+    EXPECT_EQ(norm_max(big), 5000);
+    EXPECT_EQ(argmax(big).row, 1234);
+    EXPECT_EQ(norm_inf(big), norm_1(transpos(big)));
+    auto big_row_sums = row_sums(big), big_col_sums = col_sums(big);
+    EXPECT_EQ(sum(big), std::accumulate(big_row_sums.begin(), big_row_sums.end(), 0LL));
+    EXPECT_EQ(sum(big), std::accumulate(big_col_sums.begin(), big_col_sums.end(), 0LL));
+    EXPECT_DOUBLE_EQ(frobenius_norm(MatrixArithmetic<double, true>{{3, 0}, {0, 4}}), 5.0);
+
+    // nested calls get fewer threads, rounding must stay the same
+    std::uniform_real_distribution dist {-1.0, 1.0};
+    MatrixArithmetic<double, true> real (3000, 40);
+    for (auto& row: real)
+        for (auto& elem: row)
+            elem = dist(gen) * 1e10;
+    auto top = reduce(real, {.sum = true, .frobenius = true, .col_sums = true});
+    std::vector<Reductions<double, double>> nested (4);
+    detail::parallel_for(0, 4, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; i++)
+            nested[i] = reduce(real, {.sum = true, .frobenius = true, .col_sums = true});
+    });
+    for (const auto& res_nested: nested)
+    {
+        EXPECT_EQ(res_nested.sum, top.sum);
+        EXPECT_EQ(res_nested.sum_of_squares, top.sum_of_squares);
+        EXPECT_EQ(res_nested.col_sums, top.col_sums);
+    }
+}
+
+TEST(Reduce, approx_equal)
+{
+    MatrixArithmetic<double, true> lhs = {{1.0, 2.0}, {3.0, 1e6}};
+    auto rhs = lhs;
+    rhs.to(1, 1) += 1e-3;
+    EXPECT_FALSE(approx_equal(lhs, rhs, 1e-9));
+    EXPECT_TRUE(approx_equal(lhs, rhs, 1e-9, 1e-8));
+    EXPECT_TRUE(approx_equal(lhs, rhs, 1e-2));
+    rhs.to(0, 0) = std::nan("");
+    EXPECT_FALSE(approx_equal(rhs, rhs, 1.0));
+    EXPECT_FALSE(approx_equal(lhs, transpos(lhs), 0.5));
+    EXPECT_FALSE(approx_equal(lhs, MatrixArithmetic<double, true>(2, 3), 1e9));
+
+    const double inf = std::numeric_limits<double>::infinity();
+    MatrixArithmetic<double, true> infs = {{inf, -inf}, {1.0, 2.0}};
+    EXPECT_TRUE(approx_equal(infs, infs, 1e-9));
+    EXPECT_FALSE(approx_equal(infs, transpos(infs), 1e9));
+
+    MatrixArithmetic<double, true> big (2000, 50, 1.0);
+    auto other = big;
+    EXPECT_EQ(big, other);
+    other.to(1999, 49) = 1.5;
+    EXPECT_NE(big, other);
+    EXPECT_TRUE(approx_equal(big, other, 0.5));
+    EXPECT_FALSE(approx_equal(big, other, 0.25));
+}
+
+TEST(Methods, condition_estimate)
+{
+    using MatrixD = MatrixArithmetic<double, true, DblNearCmp>;
+    std::size_t n = 8;
+    MatrixD hilbert (n, n);
+    for (std::size_t i = 0; i < n; i++)
+        for (std::size_t j = 0; j < n; j++)
+            hilbert.to(i, j) = 1.0 / static_cast<double>(i + j + 1);
+
+    std::mt19937 gen {5};
+    std::uniform_real_distribution<double> dist {-1.0, 1.0};
+    MatrixD random (60, 60);
+    for (auto& row: random)
+        for (auto& elem: row)
+            elem = dist(gen);
+
+    for (const auto& mat: {hilbert, random, transpos(random)})
+    {
+        auto mat_lu = lu(mat);
+        double exact = norm_1(mat_lu.inverse());
+        double est = mat_lu.inverse_norm_1_estimate();
+        EXPECT_LE(est, exact * (1 + 1e-9));
+        EXPECT_GE(est, exact / 3);
+        EXPECT_DOUBLE_EQ(mat_lu.rcond_1(norm_1(mat)), 1.0 / (norm_1(mat) * est));
+    }
+    EXPECT_LT(lu(hilbert).rcond_1(norm_1(hilbert)), 1e-9);
+    EXPECT_DOUBLE_EQ(lu(MatrixD{{2, 0}, {0, 4}}).rcond_1(4.0), 0.5);
+
+    MatrixD singular = {{1, 2}, {2, 4}};
+    EXPECT_EQ(lu(singular).rcond_1(norm_1(singular)), 0.0);
+    EXPECT_THROW(lu(singular).inverse_norm_1_estimate(), std::invalid_argument);
+}
+
+TEST(Expm, pade_scaling_squaring)
+{
+    using MatrixD = MatrixArithmetic<double, true, DblNearCmp>;
+    EXPECT_EQ(expm(MatrixD(3, 3)), MatrixD::eye(3));
+    EXPECT_EQ(expm(MatrixD{{0, 1}, {0, 0}}), (MatrixD{{1, 1}, {0, 1}}));
+    EXPECT_EQ(expm(MatrixD{{1e-3, 0}, {0, -2e-3}}), (MatrixD{{std::exp(1e-3), 0}, {0, std::exp(-2e-3)}}));
+    EXPECT_EQ(expm(MatrixD{{0.5, 0}, {0, 1.5}}), (MatrixD{{std::exp(0.5), 0}, {0, std::exp(1.5)}}));
+
+    double angle = 20.0;
+    auto rotation = expm(MatrixD{{0, -angle}, {angle, 0}});
+    EXPECT_EQ(rotation, (MatrixD{{std::cos(angle), -std::sin(angle)}, {std::sin(angle), std::cos(angle)}}));
+
+    std::mt19937 gen {17};
+    std::uniform_real_distribution<double> dist {-0.3, 0.3};
+    for (std::size_t n: {7, 150})
+    {
+        MatrixD mat (n, n);
+        for (auto& row: mat)
+            for (auto& elem: row)
+                elem = dist(gen);
+        auto exp_mat = expm(mat), exp_neg = expm(-mat);
+        EXPECT_TRUE(approx_equal(product(exp_mat, exp_neg), MatrixD::eye(n), 1e-10));
+        EXPECT_TRUE(approx_equal(exp_mat, expm(mat, {.cutoff = 1000}), 1e-10));
+        EXPECT_TRUE(approx_equal(product(exp_mat, exp_mat), expm(2.0 * mat), 1e-9, 1e-12));
+    }
+    EXPECT_THROW(expm(MatrixD(2, 3)), std::invalid_argument);
+}
+
+TEST(Expm, expm_multiply)
+{
+    using MatrixD = MatrixArithmetic<double, true, DblNearCmp>;
+    std::mt19937 gen {19};
+    std::uniform_real_distribution<double> dist {0.0, 1.0};
+
+    // generator of continuous time Markov chain: rows sum to zero, exp(t * Q) is stochastic
+    std::size_t n = 40;
+    MatrixD generator (n, n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        double row_sum = 0;
+        for (std::size_t j = 0; j < n; j++)
+            if (i != j)
+                row_sum += (generator.to(i, j) = dist(gen));
+        generator.to(i, i) = -row_sum;
+    }
+    DenseVector<double> ones (n, 1.0), vec (n);
+    for (auto& elem: vec)
+        elem = dist(gen);
+
+    auto stochastic = expm_multiply(generator, ones, 3.0);
+    for (auto elem: stochastic)
+        EXPECT_NEAR(elem, 1.0, 1e-12);
+
+    auto expected = gemv(expm(0.5 * generator), vec);
+    auto action = expm_multiply(generator, vec, 0.5);
+    for (std::size_t i = 0; i < n; i++)
+        EXPECT_NEAR(action[i], expected[i], 1e-12);
+
+    // shift by mean of diagonal would increase norm here, so it is not done
+    MatrixD unshifted = {{-1, 0}, {10, 3}};
+    auto unshifted_expected = gemv(expm(unshifted), DenseVector<double>{1.0, 2.0});
+    auto unshifted_action = expm_multiply(unshifted, DenseVector<double>{1.0, 2.0});
+    for (std::size_t i = 0; i < 2; i++)
+        EXPECT_NEAR(unshifted_action[i], unshifted_expected[i], 1e-12 * std::abs(unshifted_expected[i]));
+
+    EXPECT_EQ(expm_multiply(MatrixD(2, 2), DenseVector<double>{1.0, 2.0}), (DenseVector<double>{1.0, 2.0}));
+    EXPECT_THROW(expm_multiply(generator, DenseVector<double>(3)), std::invalid_argument);
+}
+
+TEST(Tiled, layouts_product_transpos)
+{
+    auto positions = MortonTiles<4>::tile_positions(4, 4);
+    EXPECT_EQ(positions[1 * 4 + 2], 6);
+    EXPECT_EQ(positions[3 * 4 + 3], 15);
+    auto compact = MortonTiles<4>::tile_positions(3, 5);
+    std::sort(compact.begin(), compact.end());
+    for (std::size_t pos = 0; pos < compact.size(); pos++)
+        EXPECT_EQ(compact[pos], pos);
+
+    std::mt19937 gen {23};
+    MatrixArithmetic<long long> lhs (70, 45), rhs (45, 90);
+    for (auto* mat: {&lhs, &rhs})
+        for (auto& row: *mat)
+            for (auto& elem: row)
+                elem = static_cast<long long>(gen() % 201) - 100;
+
+    TiledMatrix<long long> tiled_lhs {lhs}, tiled_rhs {rhs};
+    EXPECT_EQ(tiled_lhs.to_row_major(), lhs);
+    EXPECT_EQ(tiled_lhs.to(69, 44), lhs.to(69, 44));
+    EXPECT_EQ(product(tiled_lhs, tiled_rhs).to_row_major(), product(lhs, rhs));
+    EXPECT_EQ(transpos(tiled_lhs).to_row_major(), transpos(lhs));
+    EXPECT_EQ(transpos(transpos(tiled_lhs)), tiled_lhs);
+
+    TiledMatrix<long long, RowMajorTiles<16>> row_tiles {lhs};
+    EXPECT_EQ(product(row_tiles, TiledMatrix<long long, RowMajorTiles<16>>{rhs}).to_row_major(), product(lhs, rhs));
+
+    tiled_lhs.swap_row(3, 64);
+    tiled_lhs.swap_col(0, 40);
+    tiled_lhs.swap_col(44, 1);
+    lhs.swap_row(3, 64);
+    lhs.swap_col(0, 40);
+    lhs.swap_col(44, 1);
+    EXPECT_EQ(tiled_lhs.to_row_major(), lhs);
+    EXPECT_THROW(product(tiled_lhs, tiled_lhs), std::invalid_argument);
+    EXPECT_THROW(tiled_lhs.at(70, 0), std::out_of_range);
+}
+
+TEST(Tiled, lu)
+{
+    using MatrixD = MatrixArithmetic<double, true, DblCmp>;
+    std::mt19937 gen {29};
+    std::uniform_real_distribution<double> dist {-1.0, 1.0};
+    std::size_t n = 75;
+    MatrixD mat (n, n);
+    for (auto& row: mat)
+        for (auto& elem: row)
+            elem = dist(gen);
+
+    auto tiled_lu = lu(TiledMatrix<double, MortonTiles<16>>{mat});
+    EXPECT_FALSE(tiled_lu.is_singular());
+    EXPECT_EQ(tiled_lu.permutation(), lu(mat).permutation());
+    EXPECT_TRUE(DblCmp{}(tiled_lu.determinant(), lu(mat).determinant()));
+
+    DenseVector<double> rhs (n);
+    for (auto& elem: rhs)
+        elem = dist(gen);
+    auto x = tiled_lu.solve(rhs);
+    auto residual = gemv(mat, x) - rhs;
+    EXPECT_LT(norm(residual), 1e-12);
+
+    MatrixD lower (n, n), upper (n, n), permuted (n, n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        for (std::size_t j = 0; j < n; j++)
+            (j < i ? lower : upper).to(i, j) = tiled_lu.packed(i, j);
+        lower.to(i, i) = 1;
+        permuted[i] = mat[tiled_lu.permutation()[i]];
+    }
+    EXPECT_TRUE(approx_equal(product(lower, upper), permuted, 1e-12));
+
+    auto singular = lu(TiledMatrix<double>{MatrixD{{1, 2, 3}, {2, 4, 6}, {1, 0, 1}}});
+    EXPECT_TRUE(singular.is_singular());
+    EXPECT_EQ(singular.determinant(), 0.0);
+    EXPECT_THROW(singular.solve(DenseVector<double>(3)), std::invalid_argument);
+    EXPECT_THROW(lu(TiledMatrix<double>(2, 3)), std::invalid_argument);
+}
+
+TEST(Parallel, nested_regions)
+{
+    std::atomic<long long> total {0};
+    detail::parallel_for(0, 16, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; i++)
+            detail::parallel_for(0, 1000, [&](std::size_t in_first, std::size_t in_last)
+            {
+                long long part = 0;
+                for (std::size_t j = in_first; j < in_last; j++)
+                    part += static_cast<long long>(i * 1000 + j);
+                total += part;
+            }, 1, true);
+    });
+    EXPECT_EQ(total.load(), 16000LL * 15999 / 2);
+    EXPECT_EQ(detail::busy_threads().load(), 0);
+    EXPECT_EQ(detail::parallel_depth, 0);
+    EXPECT_THROW(detail::parallel_for(0, 8, [](std::size_t, std::size_t) {throw std::runtime_error{"chunk"};}),
+                 std::runtime_error);
+    EXPECT_EQ(detail::busy_threads().load(), 0);
+}
+
+TEST(Parallel, placed_partition)
+{
+    std::size_t len = 1000, n_parts = detail::placement_parts(len, 1);
+    EXPECT_EQ(detail::placement_parts(len, 2000), 1);
+    EXPECT_EQ(n_parts, std::min(len, detail::placement_cpus()));
+
+    // the same parts in outermost and nested regions
+    auto collect = [&]
+    {
+        std::vector<std::pair<std::size_t, std::size_t>> parts (n_parts);
+        std::atomic<std::size_t> n_calls {0};
+        detail::placed_parallel_for(0, len, [&](std::size_t first, std::size_t last)
+        {
+            parts[first * n_parts / len] = {first, last};
+            n_calls++;
+        }, 1);
+        EXPECT_EQ(n_calls.load(), n_parts);
+        return parts;
+    };
+    auto outer = collect();
+    for (std::size_t k = 0; k < n_parts; k++)
+        EXPECT_EQ(outer[k], std::make_pair(len * k / n_parts, len * (k + 1) / n_parts));
+    detail::parallel_for(0, 2, [&](std::size_t, std::size_t) {EXPECT_EQ(collect(), outer);});
+    EXPECT_EQ(detail::busy_threads().load(), 0);
+    EXPECT_EQ(detail::parallel_depth, 0);
+
+    EXPECT_THROW(detail::placed_parallel_for(0, 8, [](std::size_t, std::size_t) {throw std::runtime_error{"part"};}, 1),
+                 std::runtime_error);
+    EXPECT_EQ(detail::busy_threads().load(), 0);
+
+    using MatrixD = MatrixArithmetic<double, true, DblCmp>;
+    MatrixD interleaved (300, 200, 1.5, AllocationPolicy{.numa = NumaPlacement::interleave});
+    EXPECT_TRUE(interleaved.allocation().uses_block());
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(interleaved[1].data()) % detail::cache_line_size, 0);
+    EXPECT_EQ(interleaved + interleaved, MatrixD(300, 200, 3.0));
+    EXPECT_EQ(transpos(interleaved), MatrixD(200, 300, 1.5));
+}
+
+TEST(Async, task_graph)
+{
+    using MatrixD = MatrixArithmetic<double, true, DblCmp>;
+    MatrixD mat1 = {{1, 12, 3}, {23, 56.8, 78}, {43, 32, 7}};
+    MatrixD mat2 = {{4, 9, 1}, {1, 2, 0}, {0, 3, 5}};
+
+    auto lhs = async::value(mat1);
+    auto rhs = async::value(mat2);
+    auto prod = async::product(lhs, rhs);
+    auto inv  = async::inverse(rhs);
+    auto sum  = prod + inv;
+    auto det  = async::determinant(prod);
+    auto sol  = async::solve(lhs, async::value(MatrixD{1, 2, 3}));
+
+    EXPECT_EQ(sum.get(), product(mat1, mat2) + mat2.inverse());
+    EXPECT_TRUE(DblCmp{}(det.get(), mat1.determinant() * mat2.determinant()));
+    EXPECT_EQ(product(mat1, sol.get()), (MatrixD{1, 2, 3}));
+
+    auto bad = async::inverse(async::value(MatrixD{{1, 2}, {2, 4}}));
+    auto bad_dependent = async::determinant(bad);
+    EXPECT_THROW(bad_dependent.get(), std::invalid_argument);
+
+    auto node = std::make_shared<async::detail::Node<int>>();
+    node->set_value(1);
+    node->complete(std::make_exception_ptr(std::runtime_error{"late"}));
+    node->set_value(2);
+    EXPECT_EQ(async::Handle<int>{node}.get(), 1);
+}
+
+TEST(Profiler, counters)
+{
+    MatrixArithmetic mat1 {{1, 2, 12}, {14, 31, 56}};
+    MatrixArithmetic mat2 {{34, -7}, {23, 54}, {1, 2}};
+
+    profiler::reset();
+    auto res = product(mat1, mat2);
+    auto stats = profiler::stats("product");
+
+    #ifdef MATRIX_PROFILE
+    EXPECT_EQ(stats.calls, 1);
+    EXPECT_EQ(stats.flops, 2 * 2 * 2 * 3);
+    EXPECT_EQ(stats.bytes_allocated, 2 * 2 * sizeof(int));
+    EXPECT_EQ(profiler::Profiler::instance().trace().size(), 1);
+    #else
+    EXPECT_EQ(stats.calls, 0);
+    EXPECT_TRUE(profiler::snapshot().empty());
+    #endif
+}
+
 TEST(Iterators, Iterator_and_ConstIterator)
 {
     static_assert(std::random_access_iterator<MatrixArithmetic<>::iterator>);